@@ -0,0 +1,249 @@
+/**
+ * Benchmarks the image transcoding kernels of lib/image on album art sized images.
+ *
+ *   node bench/images.js [--width 300] [--height 300] [--size 144] [--rounds 20]
+ *
+ * Every round runs each kernel on a synthetic RGBA source the way image.load does: greyscale,
+ * downscale to `size` x `size`, sierra dithering to 2 bits per channel, and PNG encoding. The
+ * legacy path is the per pixel Array code the typed array kernels replaced. Throughput is reported
+ * in megapixels per second of the pixels each kernel reads.
+ */
+
+var Module = require('module');
+var path = require('path');
+
+// Resolve modules the way the PebbleKit JS bundler does
+var srcDir = path.join(__dirname, '../src/js');
+var resolveFilename = Module._resolveFilename;
+Module._resolveFilename = function(request) {
+  var args = Array.prototype.slice.call(arguments);
+  if (request === 'zlib') {
+    args[0] = path.join(srcDir, 'vendor/zlib.js');
+  } else if (/^(lib|vendor|ui)\//.test(request)) {
+    args[0] = path.join(srcDir, request + '.js');
+  }
+  return resolveFilename.apply(this, args);
+};
+global.window = global;
+global.localStorage = { getItem: function() { return null; }, setItem: function() {} };
+
+var image = require('lib/image');
+var PNGEncoder = require('lib/png-encoder');
+var PNG = require('vendor/png');
+
+var parseArgs = function(argv) {
+  var options = {
+    width: 300,
+    height: 300,
+    size: 144,
+    rounds: 20,
+  };
+  for (var i = 0; i < argv.length; i += 2) {
+    var name = argv[i].replace(/^--/, '');
+    if (!(name in options)) {
+      throw new Error('Unknown option ' + argv[i]);
+    }
+    options[name] = Number(argv[i + 1]);
+  }
+  return options;
+};
+
+var getPos = function(width, x, y) {
+  return y * width * 4 + x * 4;
+};
+
+var legacy = {};
+
+legacy.greyscale = function(pixels, width, height) {
+  for (var y = 0, yy = height; y < yy; ++y) {
+    for (var x = 0, xx = width; x < xx; ++x) {
+      var pos = getPos(width, x, y);
+      var newColor = ((pixels[pos] + pixels[pos + 1] + pixels[pos + 2]) / 3) & 0xFF;
+      for (var i = 0; i < 3; ++i) {
+        pixels[pos + i] = newColor;
+      }
+    }
+  }
+};
+
+legacy.resizeSample = function(pixels, width, height, newWidth, newHeight) {
+  var newPixels = new Array(newWidth * newHeight * 4);
+  var widthRatio = width / newWidth;
+  var heightRatio = height / newHeight;
+  for (var y = 0, yy = newHeight; y < yy; ++y) {
+    for (var x = 0, xx = newWidth; x < xx; ++x) {
+      var x2 = Math.min(parseInt(x * widthRatio), width - 1);
+      var y2 = Math.min(parseInt(y * heightRatio), height - 1);
+      var pos = getPos(newWidth, x, y);
+      for (var i = 0; i < 4; ++i) {
+        newPixels[pos + i] = ((pixels[getPos(width, x2  , y2  ) + i] +
+                               pixels[getPos(width, x2+1, y2  ) + i] +
+                               pixels[getPos(width, x2  , y2+1) + i] +
+                               pixels[getPos(width, x2+1, y2+1) + i]) / 4) & 0xFF;
+      }
+    }
+  }
+  return newPixels;
+};
+
+var getChannel2 = function(color) {
+  return Math.min(Math.max(parseInt(color / 64 + 0.5), 0) * 64, 255);
+};
+
+legacy.dither = function(pixels, width, height, dithers) {
+  var numDithers = dithers.length;
+  for (var y = 0, yy = height; y < yy; ++y) {
+    for (var x = 0, xx = width; x < xx; ++x) {
+      var pos = getPos(width, x, y);
+      for (var i = 0; i < 3; ++i) {
+        var oldColor = pixels[pos + i];
+        var newColor = getChannel2(oldColor);
+        var error = oldColor - newColor;
+        pixels[pos + i] = newColor;
+        for (var j = 0; j < numDithers; ++j) {
+          var dither = dithers[j];
+          var x2 = x + dither[0], y2 = y + dither[1];
+          if (x2 >= 0 && x2 < width && y < height) {
+            pixels[getPos(width, x2, y2) + i] += parseInt(error * dither[2]);
+          }
+        }
+      }
+    }
+  }
+};
+
+var getPixelColorUint8 = function(pixels, pos) {
+  var r = Math.min(Math.max(parseInt(pixels[pos    ] / 64 + 0.5), 0), 3);
+  var g = Math.min(Math.max(parseInt(pixels[pos + 1] / 64 + 0.5), 0), 3);
+  var b = Math.min(Math.max(parseInt(pixels[pos + 2] / 64 + 0.5), 0), 3);
+  return (0x3 << 6) | (r << 4) | (g << 2) | b;
+};
+
+legacy.toPng8 = function(pixels, width, height) {
+  var raster = [];
+  for (var y = 0; y < height; ++y) {
+    var row = raster[y] = [];
+    for (var x = 0; x < width; ++x) {
+      var pos = getPos(width, x, y);
+      row[x] = [pixels[pos], pixels[pos + 1], pixels[pos + 2]];
+    }
+  }
+
+  var palette = [];
+  var colorMap = {};
+  var numColors = 0;
+  for (y = 0; y < height; ++y) {
+    row = raster[y];
+    for (x = 0; x < width; ++x) {
+      var color = row[x];
+      var hash = getPixelColorUint8(color, 0);
+      if (!(hash in colorMap)) {
+        colorMap[hash] = numColors;
+        palette[numColors++] = color;
+      }
+      row[x] = colorMap[hash];
+    }
+  }
+
+  var bytes = PNGEncoder.encode(raster, 8, 3, palette);
+  return { width: width, height: height, pixelsLength: bytes.array.length, pixels: bytes.array };
+};
+
+//! Album art like source: smooth gradients with some deterministic noise
+var makeSource = function(width, height) {
+  var pixels = new Uint8Array(width * height * 4);
+  var seed = 1;
+  for (var y = 0, pos = 0; y < height; ++y) {
+    for (var x = 0; x < width; ++x, pos += 4) {
+      seed = (seed * 1103515245 + 12345) & 0x7fffffff;
+      var noise = (seed >> 16) & 0x1f;
+      pixels[pos    ] = (x * 255 / width + noise) & 0xFF;
+      pixels[pos + 1] = (y * 255 / height + noise) & 0xFF;
+      pixels[pos + 2] = ((x + y) * 127 / (width + height) + noise) & 0xFF;
+      pixels[pos + 3] = 255;
+    }
+  }
+  return pixels;
+};
+
+var kernels = ['greyscale', 'resizeSample', 'dither', 'toPng8'];
+
+var run = function(impl, options, source) {
+  var size = options.size;
+  var srcPixels = options.width * options.height;
+  var seconds = { greyscale: 0, resizeSample: 0, dither: 0, toPng8: 0 };
+  var pixelsRead = {
+    greyscale: srcPixels,
+    resizeSample: srcPixels,
+    dither: size * size,
+    toPng8: size * size,
+  };
+  var time = function(name, fn) {
+    var start = process.hrtime();
+    var result = fn();
+    var elapsed = process.hrtime(start);
+    seconds[name] += elapsed[0] + elapsed[1] / 1e9;
+    return result;
+  };
+
+  var png;
+  for (var round = 0; round < options.rounds; ++round) {
+    var grey = new Uint8Array(source);
+    time('greyscale', function() { impl.greyscale(grey, options.width, options.height); });
+    var pixels = time('resizeSample', function() {
+      return impl.resizeSample(new Uint8Array(source), options.width, options.height, size, size);
+    });
+    time('dither', function() { impl.dither(pixels, size, size, image.dithers.sierra); });
+    png = time('toPng8', function() { return impl.toPng8(pixels, size, size); });
+  }
+
+  var result = { png: png, total: 0 };
+  kernels.forEach(function(name) {
+    result[name] = pixelsRead[name] * options.rounds / seconds[name] / 1e6;
+    result.total += seconds[name];
+  });
+  result.pipeline = srcPixels * options.rounds / result.total / 1e6;
+  return result;
+};
+
+//! Decodes the PNG output and checks that it only uses 2 bit per channel colors
+var verify = function(png, size) {
+  var decoded = new PNG(new Uint8Array(png.pixels));
+  if (decoded.width !== size || decoded.height !== size) {
+    throw new Error('decoded ' + decoded.width + 'x' + decoded.height + ', expected ' + size);
+  }
+  var pixels = decoded.decode();
+  for (var pos = 0; pos < pixels.length; pos += 4) {
+    for (var i = 0; i < 3; ++i) {
+      if (pixels[pos + i] % 64 !== 0 && pixels[pos + i] !== 255) {
+        throw new Error('pixel ' + pos / 4 + ' is not dithered: ' + pixels[pos + i]);
+      }
+    }
+  }
+};
+
+var main = function() {
+  var options = parseArgs(process.argv.slice(2));
+  var source = makeSource(options.width, options.height);
+
+  // Warm up both paths before measuring
+  var warmup = { width: options.width, height: options.height, size: options.size, rounds: 3 };
+  run(legacy, warmup, source);
+  run(image, warmup, source);
+
+  var old = run(legacy, options, source);
+  var typed = run(image, options, source);
+  verify(old.png, options.size);
+  verify(typed.png, options.size);
+
+  console.log('source=' + options.width + 'x' + options.height + ' size=' + options.size +
+              ' rounds=' + options.rounds);
+  kernels.concat('pipeline').forEach(function(name) {
+    console.log(name + ': legacy ' + old[name].toFixed(2) + ' MP/s, typed ' +
+                typed[name].toFixed(2) + ' MP/s, speedup ' +
+                (typed[name] / old[name]).toFixed(2) + 'x');
+  });
+  console.log('png bytes: legacy ' + old.png.pixelsLength + ', typed ' + typed.png.pixelsLength);
+};
+
+main();
@@ -0,0 +1,225 @@
+/**
+ * Benchmarks packet serialization for a 500 item menu rebuild.
+ *
+ *   node bench/packets.js [--items 500] [--rounds 200] [--payload 2012]
+ *
+ * Every round writes one MenuItemPacket per item, combines them into app messages the way
+ * PacketQueue does, then decodes the messages back into DataViews and walks the packet headers
+ * as onAppMessage does. The legacy path is the byte-at-a-time Array code PacketQueue replaced,
+ * including the string encoding that went through encodeURIComponent.
+ */
+
+var struct = require('../src/js/lib/struct.js');
+var PacketQueue = require('../src/js/ui/packetqueue.js');
+
+var parseArgs = function(argv) {
+  var options = {
+    items: 500,
+    rounds: 200,
+    payload: 2044 - 32,
+  };
+  for (var i = 0; i < argv.length; i += 2) {
+    var name = argv[i].replace(/^--/, '');
+    if (!(name in options)) {
+      throw new Error('Unknown option ' + argv[i]);
+    }
+    options[name] = Number(argv[i + 1]);
+  }
+  return options;
+};
+
+var StringType = function(x) {
+  return (x === undefined) ? '' : '' + x;
+};
+
+var StringLengthType = function(x) {
+  return struct.utf8Length(StringType(x));
+};
+
+var LegacyStringLengthType = function(x) {
+  return unescape(encodeURIComponent(StringType(x))).length;
+};
+
+var legacyCstring = {
+  size: 1,
+  dynamic: true,
+  get: struct.types.cstring.get,
+  set: function(offset, value) {
+    value = unescape(encodeURIComponent(value));
+    this._grow(offset + value.length + 1);
+    var i = offset;
+    var buffer = this._view;
+    for (var j = 0, jj = value.length; j < jj; ++i, ++j) {
+      buffer.setUint8(i, value.charCodeAt(j));
+    }
+    buffer.setUint8(i, 0);
+    this._advance = value.length + 1;
+  },
+};
+
+// Mirrors MenuItemPacket in simply-pebble.js
+var makeMenuItemPacket = function(lengthType, cstring) {
+  var Packet = new struct([
+    ['uint16', 'type'],
+    ['uint16', 'length'],
+  ]);
+  return new struct([
+    [Packet, 'packet'],
+    ['uint16', 'section'],
+    ['uint16', 'item'],
+    ['uint32', 'icon'],
+    ['uint16', 'titleLength', lengthType],
+    ['uint16', 'subtitleLength', lengthType],
+    [cstring, 'title', StringType],
+    [cstring, 'subtitle', StringType],
+  ]);
+};
+
+var MenuItemType = 17;
+
+var writeMenuItem = function(MenuItemPacket, item, def) {
+  MenuItemPacket
+    .section(0)
+    .item(item)
+    .icon(def.icon)
+    .titleLength(def.title)
+    .subtitleLength(def.subtitle)
+    .title(def.title)
+    .subtitle(def.subtitle);
+  var size = Math.max(MenuItemPacket._size, MenuItemPacket._cursor);
+  MenuItemPacket.packetType(MenuItemType);
+  MenuItemPacket.packetLength(size);
+  return size;
+};
+
+var LegacyPacketQueue = function(options) {
+  this._maxPayloadSize = options.maxPayloadSize;
+  this._sendMessage = options.sendMessage;
+  this._message = [];
+  this._send = this.send.bind(this);
+};
+
+LegacyPacketQueue.toBytes = function(packet, size) {
+  var buffer = packet._view;
+  var byteArray = new Array(size);
+  for (var i = 0; i < size; ++i) {
+    byteArray[i] = buffer.getUint8(i);
+  }
+  return byteArray;
+};
+
+LegacyPacketQueue.toDataView = function(array) {
+  var length = array.length;
+  var copy = new DataView(new ArrayBuffer(length));
+  for (var i = 0; i < length; ++i) {
+    copy.setUint8(i, array[i]);
+  }
+  return copy;
+};
+
+LegacyPacketQueue.prototype.add = function(byteArray) {
+  if (this._message.length + byteArray.length > this._maxPayloadSize) {
+    this.send();
+  }
+  Array.prototype.push.apply(this._message, byteArray);
+  clearTimeout(this._timeout);
+  this._timeout = setTimeout(this._send, 0);
+};
+
+LegacyPacketQueue.prototype.send = function() {
+  if (this._message.length === 0) {
+    return;
+  }
+  this._sendMessage(this._message);
+  this._message = [];
+};
+
+var makeItems = function(count) {
+  var items = [];
+  for (var i = 0; i < count; ++i) {
+    items.push({
+      title: 'light.living_room_lamp_' + i,
+      subtitle: (i % 2 ? 'on' : 'off') + ' - Wohnzimmer Süd',
+      icon: 1 + (i % 8),
+    });
+  }
+  return items;
+};
+
+var legacyPath = {
+  Queue: LegacyPacketQueue,
+  packet: makeMenuItemPacket(LegacyStringLengthType, legacyCstring),
+};
+
+var typedPath = {
+  Queue: PacketQueue,
+  packet: makeMenuItemPacket(StringLengthType, 'cstring'),
+};
+
+var run = function(path, options, items) {
+  var Queue = path.Queue;
+  var MenuItemPacket = path.packet;
+  var messages = [];
+  var queue = new Queue({
+    maxPayloadSize: options.payload,
+    sendMessage: function(message) { messages.push(message); },
+  });
+
+  var bytes = 0;
+  var packets = 0;
+  var start = process.hrtime();
+  for (var round = 0; round < options.rounds; ++round) {
+    for (var i = 0; i < items.length; ++i) {
+      var size = writeMenuItem(MenuItemPacket, i, items[i]);
+      queue.add(Queue.toBytes(MenuItemPacket, size));
+      bytes += size;
+    }
+    queue.send();
+
+    for (var j = 0; j < messages.length; ++j) {
+      var message = messages[j];
+      var view = Queue.toDataView(message);
+      for (var offset = 0; offset < message.length; offset += view.getUint16(offset + 2, true)) {
+        packets++;
+      }
+    }
+    messages.length = 0;
+  }
+  var elapsed = process.hrtime(start);
+  clearTimeout(queue._timeout);
+
+  if (packets !== items.length * options.rounds) {
+    throw new Error('decoded ' + packets + ' packets, expected ' + items.length * options.rounds);
+  }
+
+  var seconds = elapsed[0] + elapsed[1] / 1e9;
+  return {
+    seconds: seconds,
+    bytesPerSec: bytes / seconds,
+    packetsPerSec: packets / seconds,
+  };
+};
+
+var main = function() {
+  var options = parseArgs(process.argv.slice(2));
+  var items = makeItems(options.items);
+
+  // Warm up both paths before measuring
+  run(legacyPath, { rounds: 10, payload: options.payload }, items);
+  run(typedPath, { rounds: 10, payload: options.payload }, items);
+
+  var legacy = run(legacyPath, options, items);
+  var typed = run(typedPath, options, items);
+
+  console.log('items=' + options.items + ' rounds=' + options.rounds +
+              ' payload=' + options.payload);
+  [['legacy', legacy], ['typed', typed]].forEach(function(entry) {
+    var result = entry[1];
+    console.log(entry[0] + ': ' + (result.bytesPerSec / 1e6).toFixed(2) + ' MB/s, ' +
+                result.packetsPerSec.toFixed(0) + ' packets/s, ' +
+                result.seconds.toFixed(3) + ' s');
+  });
+  console.log('speedup: ' + (typed.bytesPerSec / legacy.bytesPerSec).toFixed(2) + 'x');
+};
+
+main();
@@ -0,0 +1,403 @@
+/**
+ * Benchmarks loading the startup cache for a large Home Assistant install.
+ *
+ *   node bench/startup.js [--entities 3000] [--rounds 20] [--favorites 20]
+ *
+ * Every round loads the cached states and registries the way loadStartupCache does before the
+ * main menu is shown: into the entity store, then the friendly names of the favorites are read.
+ * The legacy path is the JSON blob per section the compact snapshot replaced, with the full
+ * registry objects Home Assistant returns.
+ *
+ * Saving compares rewriting the whole snapshot with one write-behind flush of `changes` entity
+ * updates appended to the journal.
+ *
+ * Lookups compare opening the area menu, every area and every label by scanning the registries
+ * with building the registry index once and reading its buckets.
+ */
+
+var EntityStateStore = require('../src/js/vendor/EntityStateStore.js');
+var StartupSnapshot = require('../src/js/vendor/StartupSnapshot.js');
+var StartupCacheWriter = require('../src/js/vendor/StartupCacheWriter.js');
+var RegistryIndex = require('../src/js/vendor/RegistryIndex.js');
+
+var parseArgs = function(argv) {
+  var options = {
+    entities: 3000,
+    rounds: 20,
+    favorites: 20,
+    changes: 50,
+  };
+  for (var i = 0; i < argv.length; i += 2) {
+    var name = argv[i].replace(/^--/, '');
+    if (!(name in options)) {
+      throw new Error('Unknown option ' + argv[i]);
+    }
+    options[name] = Number(argv[i + 1]);
+  }
+  return options;
+};
+
+var MemoryStorage = function() {
+  this.items = {};
+};
+
+MemoryStorage.prototype.getItem = function(key) {
+  return key in this.items ? this.items[key] : null;
+};
+
+MemoryStorage.prototype.setItem = function(key, value) {
+  this.items[key] = String(value);
+};
+
+MemoryStorage.prototype.removeItem = function(key) {
+  delete this.items[key];
+};
+
+MemoryStorage.prototype.size = function() {
+  var size = 0;
+  for (var key in this.items) {
+    size += this.items[key].length;
+  }
+  return size;
+};
+
+var DOMAINS = ['light', 'switch', 'sensor', 'binary_sensor', 'media_player', 'climate', 'cover',
+               'automation', 'script', 'person'];
+var STATES = ['on', 'off', 'unavailable', 'unknown', '21.5', 'idle', 'open', 'closed'];
+
+var hex = function(n) {
+  return ('00000000' + (n * 2654435761 >>> 0).toString(16)).slice(-8) + '4c0fa35e8d0b42c1a7e3';
+};
+
+//! Synthetic install: registries keyed by id like the config/*_registry/list handlers build them
+var makeInstall = function(options) {
+  var time = Date.parse('2026-10-01T08:00:00.000Z');
+  var install = { states: [], areas: {}, floors: {}, devices: {}, entities: {}, labels: {} };
+  var i;
+  for (i = 0; i < 5; i++) {
+    install.floors['floor_' + i] = { name: 'Floor ' + i, level: i };
+  }
+  for (i = 0; i < 60; i++) {
+    install.areas['area_' + i] = {
+      area_id: 'area_' + i, floor_id: 'floor_' + (i % 5), name: 'Area ' + i, picture: null,
+      aliases: [], icon: null, labels: [],
+    };
+  }
+  for (i = 0; i < 12; i++) {
+    install.labels['label_' + i] = {
+      label_id: 'label_' + i, name: 'Label ' + i, color: 'indigo', icon: 'mdi:tag',
+      description: null,
+    };
+  }
+  var numDevices = Math.ceil(options.entities / 2);
+  for (i = 0; i < numDevices; i++) {
+    install.devices[hex(i)] = {
+      area_id: 'area_' + (i % 60), configuration_url: null, config_entries: [hex(i + 7)],
+      connections: [['mac', '00:17:88:01:00:de:6a:' + (i % 100)]], disabled_by: null,
+      entry_type: null, id: hex(i), identifiers: [['hue', hex(i + 11)]],
+      manufacturer: 'Signify Netherlands B.V.', model: 'Hue white lamp (LWB004)',
+      name_by_user: null, name: 'Device ' + i, sw_version: '130.1.30000', hw_version: null,
+      via_device_id: hex(3),
+    };
+  }
+  for (i = 0; i < options.entities; i++) {
+    var domain = DOMAINS[i % DOMAINS.length];
+    var entity_id = domain + '.entity_' + i;
+    var changed = new Date(time - i * 61000).toISOString();
+    var attributes = { friendly_name: 'Entity ' + i, icon: 'mdi:lightbulb' };
+    if (domain === 'sensor') {
+      attributes.unit_of_measurement = '°C';
+      attributes.device_class = 'temperature';
+      attributes.state_class = 'measurement';
+    } else if (domain === 'light') {
+      attributes.supported_color_modes = ['brightness', 'color_temp'];
+      attributes.color_mode = 'color_temp';
+      attributes.brightness = i % 256;
+      attributes.min_color_temp_kelvin = 2202;
+      attributes.max_color_temp_kelvin = 6535;
+      attributes.supported_features = 40;
+    }
+    install.states.push({
+      entity_id: entity_id,
+      state: STATES[i % STATES.length],
+      attributes: attributes,
+      last_changed: changed,
+      last_updated: changed,
+      context: { id: hex(i) + 'ABCDEF', parent_id: null, user_id: null },
+    });
+    install.entities[entity_id] = {
+      area_id: i % 7 ? null : 'area_' + (i % 60), config_entry_id: hex(i + 7),
+      device_id: hex(i >> 1), disabled_by: null, entity_category: null, entity_id: entity_id,
+      hidden_by: null, icon: null, labels: i % 5 ? [] : ['label_' + (i % 12)], name: null,
+      platform: 'hue', has_entity_name: true, original_name: 'Entity ' + i,
+      translation_key: null, unique_id: hex(i + 13),
+    };
+  }
+  return install;
+};
+
+var legacy = {
+  save: function(storage, install) {
+    storage.setItem('states', JSON.stringify(install.states));
+    storage.setItem('areas', JSON.stringify(install.areas));
+    storage.setItem('floors', JSON.stringify(install.floors));
+    storage.setItem('devices', JSON.stringify(install.devices));
+    storage.setItem('entities', JSON.stringify(install.entities));
+    storage.setItem('labels', JSON.stringify(install.labels));
+  },
+  load: function(storage) {
+    return {
+      states: JSON.parse(storage.getItem('states')),
+      areas: JSON.parse(storage.getItem('areas')),
+      floors: JSON.parse(storage.getItem('floors')),
+      devices: JSON.parse(storage.getItem('devices')),
+      entities: JSON.parse(storage.getItem('entities')),
+      labels: JSON.parse(storage.getItem('labels')),
+    };
+  },
+};
+
+var snapshot = {
+  save: function(storage, install) {
+    new StartupSnapshot(storage).save(install);
+  },
+  load: function(storage) {
+    return new StartupSnapshot(storage).load();
+  },
+};
+
+var run = function(impl, options, install) {
+  var storage = new MemoryStorage();
+  impl.save(storage, install);
+  var favorites = [];
+  for (var i = 0; i < options.favorites; i++) {
+    favorites.push(install.states[i * 37 % install.states.length].entity_id);
+  }
+
+  var seconds = 0;
+  var names;
+  for (var round = 0; round < options.rounds; ++round) {
+    var start = process.hrtime();
+    var data = impl.load(storage);
+    var store = new EntityStateStore();
+    store.replaceAll(data.states);
+    names = favorites.map(function(entity_id) {
+      return store.get(entity_id).attributes.friendly_name;
+    });
+    var elapsed = process.hrtime(start);
+    seconds += elapsed[0] + elapsed[1] / 1e9;
+  }
+  return { ms: seconds * 1000 / options.rounds, size: storage.size(), names: names, data: data,
+           store: store };
+};
+
+//! Checks that the snapshot round trips everything the views read
+var verify = function(old, compact) {
+  if (old.names.join() !== compact.names.join()) {
+    throw new Error('favorite names differ');
+  }
+  if (old.store.checksum !== compact.store.checksum) {
+    throw new Error('entity store checksums differ');
+  }
+  var entity_id = Object.keys(old.data.entities)[35];
+  ['area_id', 'device_id'].forEach(function(field) {
+    if (old.data.entities[entity_id][field] !== compact.data.entities[entity_id][field]) {
+      throw new Error('entity registry ' + field + ' differs for ' + entity_id);
+    }
+  });
+  if (compact.data.entities[entity_id].labels.join() !==
+      old.data.entities[entity_id].labels.join()) {
+    throw new Error('entity registry labels differ for ' + entity_id);
+  }
+  var state = compact.store.get(old.data.states[1].entity_id);
+  if (JSON.stringify(state.attributes) !== JSON.stringify(old.data.states[1].attributes)) {
+    throw new Error('attributes differ for ' + state.entity_id);
+  }
+};
+
+//! Changes `count` entities the way a subscribe_entities delta does
+var changeStates = function(install, count, round) {
+  var changed = [];
+  for (var i = 0; i < count; i++) {
+    var entity = install.states[(i * 53 + round) % install.states.length];
+    var updated = Object.assign({}, entity, {
+      state: STATES[(i + round) % STATES.length],
+      last_updated: new Date(Date.parse(entity.last_updated) + 1000).toISOString(),
+    });
+    install.states[install.states.indexOf(entity)] = updated;
+    changed.push(updated);
+  }
+  return changed;
+};
+
+var runSave = function(options, install) {
+  var storage = new MemoryStorage();
+  var snapshot = new StartupSnapshot(storage);
+  snapshot.save(install);
+  var states = {};
+  install.states.forEach(function(entity) { states[entity.entity_id] = entity; });
+  var writer = new StartupCacheWriter(snapshot, {
+    state: function(entity_id) { return states[entity_id]; },
+    section: function(name) { return install[name]; },
+    all: function() { return install; },
+  }, { batchSize: options.changes, maxChunks: Infinity, maxJournalRatio: Infinity });
+
+  var full = { seconds: 0, chars: 0 };
+  var flush = { seconds: 0, chars: 0 };
+  for (var round = 0; round < options.rounds; ++round) {
+    var changed = changeStates(install, options.changes, round);
+    changed.forEach(function(entity) {
+      states[entity.entity_id] = entity;
+      writer.markEntity(entity.entity_id);
+    });
+
+    var start = process.hrtime();
+    writer.flush();
+    var elapsed = process.hrtime(start);
+    flush.seconds += elapsed[0] + elapsed[1] / 1e9;
+
+    start = process.hrtime();
+    full.chars += new StartupSnapshot(new MemoryStorage()).save(install);
+    elapsed = process.hrtime(start);
+    full.seconds += elapsed[0] + elapsed[1] / 1e9;
+  }
+  writer.cancel();
+  flush.chars = writer.stats.charsWritten;
+
+  // The journal applied on top of the base has to match the current states
+  var loaded = snapshot.load();
+  var store = new EntityStateStore();
+  store.replaceAll(loaded.states);
+  var expected = new EntityStateStore();
+  expected.replaceAll(install.states);
+  if (store.checksum !== expected.checksum) {
+    throw new Error('journal does not replay to the current states');
+  }
+  return {
+    fullMs: full.seconds * 1000 / options.rounds,
+    fullChars: full.chars / options.rounds,
+    flushMs: flush.seconds * 1000 / options.rounds,
+    flushChars: flush.chars / options.rounds,
+    journalLoadMs: snapshot.timings.journal,
+  };
+};
+
+//! The registry scans the area and label menus ran before the index
+var scan = {
+  entitiesForArea: function(install, area_id) {
+    var areaDevices = new Set();
+    for (var device_id in install.devices) {
+      if (install.devices[device_id].area_id === area_id) {
+        areaDevices.add(device_id);
+      }
+    }
+    var results = {};
+    for (var entity_id in install.entities) {
+      var entity = install.entities[entity_id];
+      if (entity.area_id ? entity.area_id === area_id : areaDevices.has(entity.device_id)) {
+        results[entity_id] = entity;
+      }
+    }
+    return results;
+  },
+  entitiesForLabel: function(install, label_id) {
+    var results = {};
+    for (var entity_id in install.entities) {
+      var entity = install.entities[entity_id];
+      if (entity.labels && entity.labels.includes(label_id)) {
+        results[entity_id] = entity;
+      }
+    }
+    return results;
+  },
+};
+
+var runLookups = function(options, install) {
+  var areas = Object.keys(install.areas);
+  var labels = Object.keys(install.labels);
+  var count = function(lookup) {
+    var total = 0;
+    areas.forEach(function(area_id) { total += Object.keys(lookup.area(area_id)).length; });
+    labels.forEach(function(label_id) { total += Object.keys(lookup.label(label_id)).length; });
+    return total;
+  };
+
+  var scanned = { seconds: 0 };
+  var indexed = { seconds: 0 };
+  for (var round = 0; round < options.rounds; ++round) {
+    var start = process.hrtime();
+    scanned.total = count({
+      area: function(area_id) { return scan.entitiesForArea(install, area_id); },
+      label: function(label_id) { return scan.entitiesForLabel(install, label_id); },
+    });
+    var elapsed = process.hrtime(start);
+    scanned.seconds += elapsed[0] + elapsed[1] / 1e9;
+
+    start = process.hrtime();
+    var index = new RegistryIndex();
+    index.build(install.areas, install.devices, install.entities);
+    indexed.total = count({
+      area: function(area_id) { return index.entitiesForArea(area_id); },
+      label: function(label_id) { return index.entitiesForLabel(label_id); },
+    });
+    elapsed = process.hrtime(start);
+    indexed.seconds += elapsed[0] + elapsed[1] / 1e9;
+  }
+  if (scanned.total !== indexed.total) {
+    throw new Error('registry index lists ' + indexed.total + ' entities, scan ' + scanned.total);
+  }
+
+  // Moving a device moves its entities without a rebuild
+  var device_id = Object.keys(install.devices)[0];
+  var moved = Object.assign({}, install.devices[device_id], { area_id: 'area_59' });
+  index.updateDevice(device_id, moved);
+  var rebuilt = new RegistryIndex();
+  var devices = Object.assign({}, install.devices);
+  devices[device_id] = moved;
+  rebuilt.build(install.areas, devices, install.entities);
+  if (Object.keys(index.entitiesForArea('area_59')).sort().join() !==
+      Object.keys(rebuilt.entitiesForArea('area_59')).sort().join()) {
+    throw new Error('device update does not match a rebuild');
+  }
+
+  return {
+    scanMs: scanned.seconds * 1000 / options.rounds,
+    indexMs: indexed.seconds * 1000 / options.rounds,
+    lookups: areas.length + labels.length,
+  };
+};
+
+var main = function() {
+  var options = parseArgs(process.argv.slice(2));
+  var install = makeInstall(options);
+
+  // Warm up both paths before measuring
+  var warmup = { entities: options.entities, rounds: 3, favorites: options.favorites };
+  run(legacy, warmup, install);
+  run(snapshot, warmup, install);
+
+  var old = run(legacy, options, install);
+  var compact = run(snapshot, options, install);
+  verify(old, compact);
+
+  console.log('entities=' + options.entities + ' rounds=' + options.rounds + ' favorites=' +
+              options.favorites);
+  console.log('load to first menu: legacy ' + old.ms.toFixed(2) + ' ms, snapshot ' +
+              compact.ms.toFixed(2) + ' ms, speedup ' + (old.ms / compact.ms).toFixed(2) + 'x');
+  console.log('stored chars: legacy ' + old.size + ', snapshot ' + compact.size + ' (' +
+              (compact.size / old.size * 100).toFixed(1) + '%)');
+
+  var save = runSave(options, install);
+  console.log('save ' + options.changes + ' changed entities: full rewrite ' +
+              save.fullMs.toFixed(2) + ' ms / ' + Math.round(save.fullChars) + ' chars, flush ' +
+              save.flushMs.toFixed(2) + ' ms / ' + Math.round(save.flushChars) + ' chars');
+  console.log('journal of ' + options.rounds + ' flushes replayed on load in ' +
+              save.journalLoadMs + ' ms');
+
+  var lookups = runLookups(options, install);
+  console.log(lookups.lookups + ' area and label lookups: registry scan ' +
+              lookups.scanMs.toFixed(2) + ' ms, index build and lookup ' +
+              lookups.indexMs.toFixed(2) + ' ms');
+};
+
+main();
@@ -0,0 +1,190 @@
+/**
+ * Benchmarks the app message transport against a simulated phone to watch link.
+ *
+ *   node bench/transport.js [--messages 500] [--size 1000] [--latency 40] [--loss 0.02]
+ *                           [--bandwidth 8000] [--process 5] [--timeout 500]
+ *                           [--window 1,2,4,8] [--seed 1]
+ *
+ * The link delivers messages in order, one at a time, taking `size / bandwidth` to transmit and
+ * `latency` ms each way. Each message and each ack is lost with probability `loss`, in which case
+ * the phone sees a failure after `timeout` ms. The watch has a single inbox that stays busy for
+ * `process` ms per accepted message and NACKs anything arriving while busy. It applies messages
+ * with the same sequence rule as simply_msg.c, and the run fails if they were applied out of order.
+ */
+
+var MessageQueue = require('../src/js/ui/messagequeue.js');
+
+var parseArgs = function(argv) {
+  var options = {
+    messages: 500,
+    size: 1000,
+    latency: 40,
+    loss: 0.02,
+    bandwidth: 8000,
+    process: 5,
+    timeout: 500,
+    window: '1,2,4,8',
+    seed: 1,
+  };
+  for (var i = 0; i < argv.length; i += 2) {
+    var name = argv[i].replace(/^--/, '');
+    if (!(name in options)) {
+      throw new Error('Unknown option ' + argv[i]);
+    }
+    options[name] = name === 'window' ? argv[i + 1] : Number(argv[i + 1]);
+  }
+  options.window = options.window.split(',').map(Number);
+  return options;
+};
+
+var makeRandom = function(seed) {
+  var x = seed >>> 0 || 1;
+  return function() {
+    x ^= x << 13;
+    x ^= x >>> 17;
+    x ^= x << 5;
+    return (x >>> 0) / 0x100000000;
+  };
+};
+
+var Clock = function() {
+  this.now = 0;
+  this._events = [];
+};
+
+Clock.prototype.at = function(time, fn) {
+  var events = this._events;
+  var lo = 0;
+  var hi = events.length;
+  while (lo < hi) {
+    var mid = (lo + hi) >> 1;
+    if (events[mid].time <= time) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  events.splice(lo, 0, { time: time, fn: fn });
+};
+
+Clock.prototype.run = function() {
+  while (this._events.length) {
+    var event = this._events.shift();
+    this.now = event.time;
+    event.fn();
+  }
+};
+
+var SimulatedWatch = function() {
+  this.busyUntil = 0;
+  this.seq = 0;
+  this.session = 0;
+  this.applied = [];
+  this.outOfOrder = 0;
+};
+
+SimulatedWatch.prototype.receive = function(message, now, processMs) {
+  if (now < this.busyUntil) {
+    return false;
+  }
+  this.busyUntil = now + processMs;
+
+  var seq = message[MessageQueue.SEQUENCE_KEY];
+  var session = message[MessageQueue.SESSION_KEY];
+  if (session && session !== this.session) {
+    this.seq = seq;
+    this.session = session;
+  }
+  if (seq !== this.seq) {
+    this.outOfOrder++;
+    return true;
+  }
+  this.seq = (this.seq + 1) & MessageQueue.SEQUENCE_MASK;
+  this.applied.push(message.id);
+  return true;
+};
+
+var runWindow = function(options, windowSize) {
+  var clock = new Clock();
+  var random = makeRandom(options.seed);
+  var watch = new SimulatedWatch();
+  var linkFreeAt = 0;
+  var transmitMs = options.size / options.bandwidth * 1000;
+
+  var sendAppMessage = function(message, success, failure) {
+    var start = Math.max(clock.now, linkFreeAt);
+    linkFreeAt = start + transmitMs;
+    var arrival = linkFreeAt + options.latency;
+    if (random() < options.loss) {
+      clock.at(clock.now + options.timeout, failure);
+      return;
+    }
+    clock.at(arrival, function() {
+      var accepted = watch.receive(message, clock.now, options.process);
+      var ackLost = accepted && random() < options.loss;
+      if (ackLost) {
+        clock.at(clock.now + options.timeout, failure);
+      } else {
+        clock.at(clock.now + options.latency, accepted ? success : failure);
+      }
+    });
+  };
+
+  var queue = new MessageQueue({ windowSize: windowSize, sendAppMessage: sendAppMessage });
+  var data = new Array(options.size);
+  for (var i = 0; i < options.messages; ++i) {
+    queue.send({ 0: data, id: i });
+  }
+  clock.run();
+
+  for (var j = 0; j < options.messages; ++j) {
+    if (watch.applied[j] !== j) {
+      throw new Error('window ' + windowSize + ': message ' + j + ' applied out of order');
+    }
+  }
+  if (watch.applied.length !== options.messages) {
+    throw new Error('window ' + windowSize + ': applied ' + watch.applied.length + ' messages');
+  }
+
+  var seconds = clock.now / 1000;
+  return {
+    window: windowSize,
+    seconds: seconds,
+    messagesPerSec: options.messages / seconds,
+    bytesPerSec: options.messages * options.size / seconds,
+    retransmits: queue.stats.retransmits,
+    nacks: queue.stats.nacks,
+    discarded: watch.outOfOrder,
+  };
+};
+
+var pad = function(value, width) {
+  value = String(value);
+  while (value.length < width) {
+    value = ' ' + value;
+  }
+  return value;
+};
+
+var main = function() {
+  var options = parseArgs(process.argv.slice(2));
+  console.log('messages=' + options.messages + ' size=' + options.size +
+              ' latency=' + options.latency + 'ms loss=' + options.loss +
+              ' bandwidth=' + options.bandwidth + 'B/s process=' + options.process + 'ms');
+  console.log(['window', 'seconds', 'msgs/sec', 'bytes/sec', 'retransmits', 'nacks', 'discarded']
+    .map(function(title) { return pad(title, 12); }).join(''));
+  options.window.forEach(function(windowSize) {
+    var result = runWindow(options, windowSize);
+    console.log([
+      result.window,
+      result.seconds.toFixed(2),
+      result.messagesPerSec.toFixed(1),
+      result.bytesPerSec.toFixed(0),
+      result.retransmits,
+      result.nacks,
+      result.discarded,
+    ].map(function(value) { return pad(value, 12); }).join(''));
+  });
+};
+
+main();
@@ -18,6 +18,12 @@ const appVersion = '1.2', // displays in loading screen
     HAWS = require('vendor/haws'),
     FavoriteEntityStore = require('vendor/FavoriteEntityStore'),
     PinnedEntityStore = require('vendor/PinnedEntityStore'),
+    EntityStateStore = require('vendor/EntityStateStore'),
+    StartupSnapshot = require('vendor/StartupSnapshot'),
+    StartupCacheWriter = require('vendor/StartupCacheWriter'),
+    RegistryIndex = require('vendor/RegistryIndex'),
+    RegistryUpdates = require('vendor/RegistryUpdates'),
+    StartupScheduler = require('vendor/StartupScheduler'),
     Feature = require('platform/feature'),
     Vector = require('vector2'),
     sortJSON = require('vendor/sortjson'),
@@ -104,7 +110,6 @@ Settings.config({
 // Set some variables for quicker access
 let ha_url = null,
     ha_password = null,
-    ha_refresh_interval = null,
     ha_order_by = null,
     ha_order_dir = null,
     voice_enabled = null,
@@ -144,7 +149,6 @@ function load_settings() {
     // Set some variables for quicker access
     ha_url = Settings.option('ha_url');
     ha_password = Settings.option('token');
-    ha_refresh_interval = Settings.option('refreshTime') ? Settings.option('refreshTime') : 15;
     ha_order_by = Settings.option('order_by') || 'attributes.friendly_name';
     ha_order_dir = Settings.option('order_dir') || 'asc';
     voice_enabled = Feature.microphone(true, false) && Settings.option('voice_enabled') !== false;
@@ -251,11 +255,16 @@ let haws = null,
     entity_registry_cache = null,
     favoriteEntityStore = new FavoriteEntityStore(),
     pinnedEntityStore = new PinnedEntityStore(),
+    entityStateStore = new EntityStateStore(),
+    registryIndex = new RegistryIndex(),
+    registryUpdates = new RegistryUpdates(applyRegistryChanges, { log: log_message }),
     label_registry_cache = null;
 
 let device_status,
-    ha_state_cache = null,
-    ha_state_dict = null,
+    // Fetch order and phase trace of the current connection attempt, handed to on_auth_ok
+    startupScheduler = null,
+    // Startup that showed the main menu without cached data, views wait for its tasks
+    uncachedStartup = null,
     ha_state_cache_updated = null,
     saved_windows = null;
 //let events;
@@ -263,53 +272,77 @@ let device_status,
 log_message('ha_url: ' + baseurl);
 
 // Cache management functions for startup data
-const CACHE_KEYS = {
-    STATES: 'ha_startup_cache_states',
-    AREAS: 'ha_startup_cache_areas',
-    FLOORS: 'ha_startup_cache_floors',
-    DEVICES: 'ha_startup_cache_devices',
-    ENTITIES: 'ha_startup_cache_entities',
-    LABELS: 'ha_startup_cache_labels',
-    PIPELINES: 'ha_startup_cache_pipelines',
-    TIMESTAMP: 'ha_startup_cache_timestamp'
-};
+const startupSnapshot = new StartupSnapshot();
+
+// Per-section JSON blobs written before the compact snapshot, removed on the next save
+const LEGACY_CACHE_KEYS = [
+    'ha_startup_cache_states',
+    'ha_startup_cache_areas',
+    'ha_startup_cache_floors',
+    'ha_startup_cache_devices',
+    'ha_startup_cache_entities',
+    'ha_startup_cache_labels',
+    'ha_startup_cache_pipelines',
+    'ha_startup_cache_timestamp'
+];
+
+// Last measured time to first menu with and without the startup cache
+const FIRST_MENU_TIMING_KEY = 'ha_startup_first_menu_ms';
+
+// Startup cache sections besides the entity states, refetched on every connect
+const STARTUP_CACHE_SECTIONS = ['areas', 'floors', 'devices', 'entities', 'labels', 'pipelines'];
+
+/**
+ * Current data for the startup cache, sections that were not fetched yet are null and keep
+ * their previously saved contents
+ */
+function getStartupCacheData() {
+    return {
+        states: ha_state_cache_updated ? entityStateStore.all() : null,
+        areas: area_registry_cache,
+        floors: floor_registry_cache,
+        devices: device_registry_cache,
+        entities: entity_registry_cache,
+        labels: label_registry_cache,
+        pipelines: ha_pipelines ? {
+            pipelines: ha_pipelines,
+            preferred_pipeline: preferred_pipeline
+        } : null
+    };
+}
+
+// Changes reach the startup cache in small deferred batches instead of full rewrites. Removed
+// entities are journaled too, the store notifies their watchers with an undefined state.
+const startupCacheWriter = new StartupCacheWriter(startupSnapshot, {
+    state: entity_id => entityStateStore.get(entity_id),
+    section: name => getStartupCacheData()[name],
+    all: getStartupCacheData
+}, {
+    log: log_message
+});
+
+if (startup_cache_enabled) {
+    entityStateStore.watch(null, function(entity, entity_id) {
+        startupCacheWriter.markEntity(entity_id);
+    });
+}
 
-function saveStartupCache() {
+/**
+ * @param {string[]} [sections] - the refetched sections, all of STARTUP_CACHE_SECTIONS by default
+ */
+function saveStartupCache(sections) {
     if (!startup_cache_enabled) return;
 
     try {
-        log_message('Saving startup cache...');
-
-        // Save each piece of data to localStorage
-        if (ha_state_cache) {
-            localStorage.setItem(CACHE_KEYS.STATES, JSON.stringify(ha_state_cache));
-        }
-        if (area_registry_cache) {
-            localStorage.setItem(CACHE_KEYS.AREAS, JSON.stringify(area_registry_cache));
-        }
-        if (floor_registry_cache) {
-            localStorage.setItem(CACHE_KEYS.FLOORS, JSON.stringify(floor_registry_cache));
-        }
-        if (device_registry_cache) {
-            localStorage.setItem(CACHE_KEYS.DEVICES, JSON.stringify(device_registry_cache));
-        }
-        if (entity_registry_cache) {
-            localStorage.setItem(CACHE_KEYS.ENTITIES, JSON.stringify(entity_registry_cache));
-        }
-        if (label_registry_cache) {
-            localStorage.setItem(CACHE_KEYS.LABELS, JSON.stringify(label_registry_cache));
-        }
-        if (ha_pipelines) {
-            localStorage.setItem(CACHE_KEYS.PIPELINES, JSON.stringify({
-                pipelines: ha_pipelines,
-                preferred_pipeline: preferred_pipeline
-            }));
+        // Entity changes are already tracked through the entity store, only the refetched
+        // registries are queued here. Without a stored snapshot the first flush writes a full one.
+        for (let name of sections || STARTUP_CACHE_SECTIONS) {
+            startupCacheWriter.markSection(name);
         }
 
-        // Save timestamp
-        localStorage.setItem(CACHE_KEYS.TIMESTAMP, Date.now().toString());
-
-        log_message('Startup cache saved successfully');
+        for (let key of LEGACY_CACHE_KEYS) {
+            localStorage.removeItem(key);
+        }
     } catch (e) {
         log_message('Error saving startup cache: ' + e);
     }
@@ -321,60 +354,36 @@ function loadStartupCache() {
     try {
         log_message('Loading startup cache...');
 
-        // Check if we have a timestamp (indicates cache exists)
-        const timestamp = localStorage.getItem(CACHE_KEYS.TIMESTAMP);
-        if (!timestamp) {
+        const snapshot = startupSnapshot.load();
+        if (!snapshot) {
             log_message('No startup cache found');
             return false;
         }
 
-        // Load each piece of data
-        const statesStr = localStorage.getItem(CACHE_KEYS.STATES);
-        const areasStr = localStorage.getItem(CACHE_KEYS.AREAS);
-        const floorsStr = localStorage.getItem(CACHE_KEYS.FLOORS);
-        const devicesStr = localStorage.getItem(CACHE_KEYS.DEVICES);
-        const entitiesStr = localStorage.getItem(CACHE_KEYS.ENTITIES);
-        const labelsStr = localStorage.getItem(CACHE_KEYS.LABELS);
-        const pipelinesStr = localStorage.getItem(CACHE_KEYS.PIPELINES);
-
-        // Parse and assign cached data
-        if (statesStr) {
-            ha_state_cache = JSON.parse(statesStr);
-            let new_state_map = {};
-            for(let entity of ha_state_cache) {
-                new_state_map[entity.entity_id] = entity;
-            }
-            ha_state_dict = new_state_map;
+        // After a reconnect the entity store is newer than the cache and only needs the resync
+        // from its subscription snapshot
+        if (snapshot.states && !ha_state_cache_updated) {
+            startupCacheWriter.suspended(() => entityStateStore.replaceAll(snapshot.states));
             ha_state_cache_updated = new Date();
 
             // Update favorite entity friendly names from cached state data
-            favoriteEntityStore.updateFriendlyNames(ha_state_dict);
-        }
-
-        if (areasStr) {
-            area_registry_cache = JSON.parse(areasStr);
-        }
-
-        if (floorsStr) {
-            floor_registry_cache = JSON.parse(floorsStr);
-        }
-
-        if (devicesStr) {
-            device_registry_cache = JSON.parse(devicesStr);
+            favoriteEntityStore.updateFriendlyNames(entityStateStore.states);
         }
 
-        if (entitiesStr) {
-            entity_registry_cache = JSON.parse(entitiesStr);
+        // Registries still in memory after a reconnect were kept current by their update events
+        // and are at least as new as the cache
+        if (!area_registry_cache || !device_registry_cache || !entity_registry_cache) {
+            registryIndex.invalidate();
         }
+        area_registry_cache = area_registry_cache || snapshot.areas;
+        floor_registry_cache = floor_registry_cache || snapshot.floors;
+        device_registry_cache = device_registry_cache || snapshot.devices;
+        entity_registry_cache = entity_registry_cache || snapshot.entities;
+        label_registry_cache = label_registry_cache || snapshot.labels;
 
-        if (labelsStr) {
-            label_registry_cache = JSON.parse(labelsStr);
-        }
-
-        if (pipelinesStr) {
-            const pipelineData = JSON.parse(pipelinesStr);
-            ha_pipelines = pipelineData.pipelines;
-            preferred_pipeline = pipelineData.preferred_pipeline;
+        if (snapshot.pipelines) {
+            ha_pipelines = snapshot.pipelines.pipelines;
+            preferred_pipeline = snapshot.pipelines.preferred_pipeline;
 
             // Restore pipeline settings
             if (ha_pipelines && ha_pipelines.length > 0) {
@@ -391,8 +400,9 @@ function loadStartupCache() {
             }
         }
 
-        const cacheAge = Date.now() - parseInt(timestamp);
-        log_message('Startup cache loaded successfully (age: ' + (cacheAge / 1000).toFixed(1) + 's)');
+        const cacheAge = Date.now() - snapshot.timestamp;
+        log_message('Startup cache loaded successfully (age: ' + (cacheAge / 1000).toFixed(1) + 's, ' +
+            'timings: ' + JSON.stringify(startupSnapshot.timings) + ')');
         return true;
     } catch (e) {
         log_message('Error loading startup cache: ' + e);
@@ -405,20 +415,45 @@ function clearStartupCache() {
 
     try {
         log_message('Clearing startup cache...');
-        localStorage.removeItem(CACHE_KEYS.STATES);
-        localStorage.removeItem(CACHE_KEYS.AREAS);
-        localStorage.removeItem(CACHE_KEYS.FLOORS);
-        localStorage.removeItem(CACHE_KEYS.DEVICES);
-        localStorage.removeItem(CACHE_KEYS.ENTITIES);
-        localStorage.removeItem(CACHE_KEYS.LABELS);
-        localStorage.removeItem(CACHE_KEYS.PIPELINES);
-        localStorage.removeItem(CACHE_KEYS.TIMESTAMP);
+        startupCacheWriter.cancel();
+        startupSnapshot.clear();
+        for (let key of LEGACY_CACHE_KEYS) {
+            localStorage.removeItem(key);
+        }
         log_message('Startup cache cleared');
     } catch (e) {
         log_message('Error clearing startup cache: ' + e);
     }
 }
 
+/**
+ * Log the time from auth_ok to the first menu next to the last time measured the other way, so
+ * the gain from the startup cache shows up in the logs
+ * @param {number} elapsed_ms
+ * @param {boolean} fromCache - whether the menu was built from the startup cache
+ */
+function logTimeToFirstMenu(elapsed_ms, fromCache) {
+    let timings = {};
+    try {
+        timings = JSON.parse(localStorage.getItem(FIRST_MENU_TIMING_KEY)) || {};
+    } catch (e) {}
+
+    const source = fromCache ? 'cache' : 'network';
+    const other = timings[fromCache ? 'network' : 'cache'];
+    let message = 'Time to first menu: ' + elapsed_ms + 'ms from ' + source;
+    if (other) {
+        message += fromCache
+            ? ' (' + (other - elapsed_ms) + 'ms faster than the last network start, ' + other + 'ms)'
+            : ' (last start from cache took ' + other + 'ms)';
+    }
+    log_message(message);
+
+    timings[source] = elapsed_ms;
+    try {
+        localStorage.setItem(FIRST_MENU_TIMING_KEY, JSON.stringify(timings));
+    } catch (e) {}
+}
+
 /**
  * Restart the app after settings change
  * This will disconnect HAWS, clear all windows, and reinitialize the app
@@ -456,16 +491,19 @@ function restartApp() {
     mainMenu = null;
     areaMenu = null;
     areaMenuUsingFloors = null;
+    uncachedStartup = null;
 
     // Reset state variables
-    ha_state_cache = null;
-    ha_state_dict = null;
+    entityStateStore.detach();
+    entityStateStore.replaceAll([]);
     ha_state_cache_updated = null;
     area_registry_cache = null;
     floor_registry_cache = null;
     device_registry_cache = null;
     entity_registry_cache = null;
     label_registry_cache = null;
+    registryIndex.invalidate();
+    registryUpdates.clear();
     ha_pipelines = null;
     preferred_pipeline = null;
     selected_pipeline = null;
@@ -623,7 +661,7 @@ function getMainMenuItem(itemId) {
     // Handle pinned entities (format: "pinned:entity_id")
     if (itemId.startsWith('pinned:')) {
         const entityId = itemId.substring(7);
-        const entity = ha_state_dict ? ha_state_dict[entityId] : null;
+        const entity = entityStateStore.get(entityId);
         if (!entity) {
             // Entity not found in state dict, skip it
             return null;
@@ -660,7 +698,7 @@ function getMainMenuItem(itemId) {
                 id: 'areas',
                 title: "Areas",
                 on_click: function(e) {
-                    showAreaMenu();
+                    whenStartupDone(['areas', 'floors', 'devices', 'entities'], showAreaMenu);
                 }
             };
         case 'labels':
@@ -668,7 +706,7 @@ function getMainMenuItem(itemId) {
                 id: 'labels',
                 title: "Labels",
                 on_click: function(e) {
-                    showLabelMenu();
+                    whenStartupDone(['labels', 'entities'], showLabelMenu);
                 }
             };
         case 'todo_lists':
@@ -676,7 +714,7 @@ function getMainMenuItem(itemId) {
                 id: 'todo_lists',
                 title: "To-Do Lists",
                 on_click: function(e) {
-                    showToDoLists();
+                    whenStartupDone(['states'], showToDoLists);
                 }
             };
         case 'people':
@@ -684,11 +722,11 @@ function getMainMenuItem(itemId) {
                 id: 'people',
                 title: "People",
                 on_click: function(e) {
-                    // Get all person entities
-                    const personEntities = Object.keys(ha_state_dict).filter(function(entity_id) {
-                        return entity_id.startsWith('person.');
+                    whenStartupDone(['states'], function() {
+                        // Get all person entities
+                        const personEntities = entityStateStore.idsForDomain('person');
+                        showEntityList("People", personEntities, true, true, true);
                     });
-                    showEntityList("People", personEntities, true, true, true);
                 }
             };
         case 'all_entities':
@@ -696,13 +734,15 @@ function getMainMenuItem(itemId) {
                 id: 'all_entities',
                 title: "All Entities",
                 on_click: function(e) {
-                    const entityKeys = Object.keys(ha_state_dict);
-                    const shouldShowDomains = shouldShowDomainMenu(entityKeys, domain_menu_all_entities);
-                    if (shouldShowDomains) {
-                        showEntityDomainsFromList(entityKeys, "All Entities");
-                    } else {
-                        showEntityList("All Entities", false, true, true, true);
-                    }
+                    whenStartupDone(['states'], function() {
+                        const entityKeys = entityStateStore.ids();
+                        const shouldShowDomains = shouldShowDomainMenu(entityKeys, domain_menu_all_entities);
+                        if (shouldShowDomains) {
+                            showEntityDomainsFromList(entityKeys, "All Entities");
+                        } else {
+                            showEntityList("All Entities", false, true, true, true);
+                        }
+                    });
                 }
             };
         case 'settings':
@@ -787,10 +827,9 @@ function getMainMenuOrder() {
 }
 
 let mainMenu = null;
-let mainMenuSubscriptionId = null;
+let mainMenuWatchId = null;
 let mainMenuPinnedEntityIndexes = {}; // Maps entity_id to menu index for pinned entities
 let mainMenuRelativeTimeUpdater = null; // RelativeTimeUpdater for pinned entities
-let mainMenuEntityStates = {}; // Local state cache for pinned entities
 
 function showMainMenu() {
     if(!mainMenu) {
@@ -810,12 +849,11 @@ function showMainMenu() {
         mainMenu.on('show', function(){
             mainMenu.items(0, []);
             mainMenuPinnedEntityIndexes = {};
-            mainMenuEntityStates = {};
 
-            // Unsubscribe from previous subscription if exists
-            if (mainMenuSubscriptionId) {
-                haws.unsubscribe(mainMenuSubscriptionId);
-                mainMenuSubscriptionId = null;
+            // Stop watching from a previous show if still registered
+            if (mainMenuWatchId) {
+                entityStateStore.unwatch(mainMenuWatchId);
+                mainMenuWatchId = null;
             }
 
             // Clear and recreate the RelativeTimeUpdater
@@ -833,7 +871,7 @@ function showMainMenu() {
                     return; // Entity not currently rendered
                 }
 
-                let entity = mainMenuEntityStates[entity_id];
+                let entity = entityStateStore.get(entity_id);
                 if (!entity) {
                     return;
                 }
@@ -861,67 +899,33 @@ function showMainMenu() {
                 }
             }
 
-            // Subscribe to state changes for pinned entities
+            // Watch pinned entities, items were rendered from the entity store above
             if (pinnedEntityIds.length > 0) {
-                log_message(`Main menu: subscribing to ${pinnedEntityIds.length} pinned entities`);
-
-                mainMenuSubscriptionId = haws.subscribeEntities(pinnedEntityIds, function(data) {
-                    let ev = data.event || {};
-
-                    // Handle added entities (initial snapshot) - update display
-                    if (ev.a) {
-                        for (let entity_id in ev.a) {
-                            if (mainMenuPinnedEntityIndexes[entity_id] !== undefined) {
-                                let entityData = {
-                                    entity_id: entity_id,
-                                    state: ev.a[entity_id].s,
-                                    attributes: ev.a[entity_id].a || {},
-                                    last_changed: ev.a[entity_id].lc ? new Date(ev.a[entity_id].lc * 1000).toISOString() : new Date().toISOString()
-                                };
-                                ha_state_dict[entity_id] = entityData;
-                                mainMenuEntityStates[entity_id] = entityData;
-                                updateEntityMenuItem(mainMenu, 0, mainMenuPinnedEntityIndexes[entity_id], entityData);
-
-                                // Register entity for relative time updates
-                                if (mainMenuRelativeTimeUpdater) {
-                                    mainMenuRelativeTimeUpdater.register(entity_id, entityData.last_changed);
-                                }
-                            }
-                        }
+                for (let entity_id of pinnedEntityIds) {
+                    let entity = entityStateStore.get(entity_id);
+                    if (entity) {
+                        mainMenuRelativeTimeUpdater.register(entity_id, entity.last_changed);
                     }
+                }
 
-                    // Handle changed entities (updates)
-                    if (ev.c) {
-                        for (let entity_id in ev.c) {
-                            if (mainMenuPinnedEntityIndexes[entity_id] !== undefined) {
-                                let patch = ev.c[entity_id];
-                                let plus = patch["+"] || {};
-
-                                // Get existing state or create new one
-                                let cur = mainMenuEntityStates[entity_id] || ha_state_dict[entity_id] || { entity_id: entity_id, state: '', attributes: {} };
-
-                                // Merge the changes
-                                let entityData = {
-                                    entity_id: entity_id,
-                                    state: plus.s !== undefined ? plus.s : cur.state,
-                                    attributes: plus.a !== undefined ? plus.a : cur.attributes,
-                                    last_changed: plus.lc !== undefined ? new Date(plus.lc * 1000).toISOString() : cur.last_changed
-                                };
-                                ha_state_dict[entity_id] = entityData;
-                                mainMenuEntityStates[entity_id] = entityData;
-
-                                log_message(`Main menu: entity update for ${entity_id}: ${entityData.state}`);
-                                updateEntityMenuItem(mainMenu, 0, mainMenuPinnedEntityIndexes[entity_id], entityData);
-
-                                // Update the relative time timer with the new last_changed timestamp
-                                if (mainMenuRelativeTimeUpdater) {
-                                    mainMenuRelativeTimeUpdater.update(entity_id, entityData.last_changed);
-                                }
-                            }
+                mainMenuWatchId = entityStateStore.watch(pinnedEntityIds, function(entity, entity_id) {
+                    if (mainMenuPinnedEntityIndexes[entity_id] === undefined) {
+                        return;
+                    }
+                    if (!entity) {
+                        // Removed from Home Assistant, the row goes with the next show
+                        if (mainMenuRelativeTimeUpdater) {
+                            mainMenuRelativeTimeUpdater.unregister(entity_id);
                         }
+                        return;
+                    }
+                    log_message(`Main menu: entity update for ${entity_id}: ${entity.state}`);
+                    updateEntityMenuItem(mainMenu, 0, mainMenuPinnedEntityIndexes[entity_id], entity);
+
+                    // Update the relative time timer with the new last_changed timestamp
+                    if (mainMenuRelativeTimeUpdater) {
+                        mainMenuRelativeTimeUpdater.update(entity_id, entity.last_changed);
                     }
-                }, function(error) {
-                    log_message(`Main menu subscribeEntities ERROR: ` + JSON.stringify(error));
                 });
             }
 
@@ -932,11 +936,10 @@ function showMainMenu() {
         });
 
         mainMenu.on('hide', function() {
-            // Unsubscribe from entity updates when menu is hidden
-            if (mainMenuSubscriptionId) {
-                haws.unsubscribe(mainMenuSubscriptionId);
-                mainMenuSubscriptionId = null;
-                log_message('Main menu: unsubscribed from entity updates');
+            // Stop watching entity updates when menu is hidden
+            if (mainMenuWatchId) {
+                entityStateStore.unwatch(mainMenuWatchId);
+                mainMenuWatchId = null;
             }
             // Pause relative time updates when menu is hidden
             if (mainMenuRelativeTimeUpdater) {
@@ -2535,18 +2538,21 @@ function showFavorites() {
 
 let areaMenu = null;
 let areaMenuUsingFloors = null;  // Track if current menu was built with floors
+let areaMenuComplete = false;  // Track if current menu was built with every registry loaded
 
 function showAreaMenu() {
     // Check if we should use floors (HA 2024.4+ with at least one floor configured)
     const useFloors = floor_registry_cache && Object.keys(floor_registry_cache).length > 0;
 
-    // Recreate menu if floor mode changed
-    if (areaMenu && areaMenuUsingFloors !== useFloors) {
+    // Recreate menu if floor mode changed or it was built before the registries arrived
+    if (areaMenu && (areaMenuUsingFloors !== useFloors || !areaMenuComplete)) {
         areaMenu = null;
     }
 
     if (!areaMenu) {
         areaMenuUsingFloors = useFloors;
+        areaMenuComplete = !!(area_registry_cache && floor_registry_cache &&
+            device_registry_cache && entity_registry_cache);
 
         if (useFloors) {
             // Show floors list - user navigates: Areas -> Floor -> Areas in that floor
@@ -2758,7 +2764,7 @@ function showLabelMenu() {
 
     labelMenu.on('show', function(e) {
         // Sort labels by name
-        let sortedLabels = Object.values(label_registry_cache)
+        let sortedLabels = Object.values(label_registry_cache || {})
             .filter(label => label && label.name) // Ensure valid labels
             .sort((a, b) => {
                 if (a.name < b.name) return -1;
@@ -2802,9 +2808,9 @@ function showLabelMenu() {
 
 function showEntitiesForLabel(label_id) {
     let entities = getEntitiesForLabel(label_id);
-    let label = label_registry_cache[label_id];
+    let label = label_registry_cache && label_registry_cache[label_id];
 
-    if(!entities) {
+    if(!entities || !label) {
         return;
     }
 
@@ -2825,15 +2831,7 @@ function getEntitiesForLabel(label_id) {
         return false;
     }
 
-    const results = {};
-    for (const entity_id in entity_registry_cache) {
-        let entity = entity_registry_cache[entity_id];
-        if (entity.labels && entity.labels.includes(label_id)) {
-            results[entity_id] = entity;
-        }
-    }
-
-    return results;
+    return getRegistryIndex().entitiesForLabel(label_id);
 }
 
 //{
@@ -2863,10 +2861,10 @@ function getEntitiesForLabel(label_id) {
 //     }
 // }
 function showMediaPlayerEntity(entity_id) {
-    let mediaPlayer = ha_state_dict[entity_id],
+    let mediaPlayer = entityStateStore.get(entity_id),
         subscription_msg_id = null;
     if (!mediaPlayer) {
-        throw new Error(`Media player entity ${entity_id} not found in ha_state_dict`);
+        throw new Error(`Media player entity ${entity_id} not found in entity store`);
     }
 
     const PAUSE = 'Pause',
@@ -3034,17 +3032,11 @@ function showMediaPlayerEntity(entity_id) {
     position_progress_fg.maxWidth = position_progress_bg_inner.position2().x - position_progress_bg_inner.position().x;
 
     mediaControlWindow.on('show', function(){
-        subscription_msg_id = haws.subscribeTrigger({
-            "type": "subscribe_trigger",
-            "trigger": {
-                "platform": "state",
-                "entity_id": entity_id,
-            },
-        }, function(data) {
-            // console.log("received media_player subscription event", JSON.stringify(data) );
-            updateMediaWindow(data.event.variables.trigger.to_state);
-        }, function(error) {
-            log_message(`ENTITY UPDATE ERROR [${entity.entity_id}]: ` + JSON.stringify(error));
+        subscription_msg_id = entityStateStore.watch(entity_id, function(updatedMediaPlayer) {
+            if (!updatedMediaPlayer) {
+                return;
+            }
+            updateMediaWindow(updatedMediaPlayer);
         });
 
         mediaControlWindow.on('click', 'select', function(e) {
@@ -3098,7 +3090,7 @@ function showMediaPlayerEntity(entity_id) {
 
     mediaControlWindow.on('close', function(){
         if (subscription_msg_id) {
-            haws.unsubscribe(subscription_msg_id);
+            entityStateStore.unwatch(subscription_msg_id);
         }
     });
 
@@ -3172,10 +3164,10 @@ function showMediaPlayerEntity(entity_id) {
 }
 
 function showClimateEntity(entity_id) {
-    let climate = ha_state_dict[entity_id],
+    let climate = entityStateStore.get(entity_id),
         subscription_msg_id = null;
     if (!climate) {
-        throw new Error(`Climate entity ${entity_id} not found in ha_state_dict`);
+        throw new Error(`Climate entity ${entity_id} not found in entity store`);
     }
 
     log_message(`Showing climate entity ${entity_id}: ${JSON.stringify(climate, null, 4)}`);
@@ -3238,7 +3230,7 @@ function showClimateEntity(entity_id) {
 
     climateMenu.on('show', function() {
         // Get the latest climate data
-        climate = ha_state_dict[entity_id];
+        climate = entityStateStore.get(entity_id);
         climateData = getClimateData(climate);
         supportedFeatures = getSupportedFeatures(climateData.supported_features);
 
@@ -3261,7 +3253,7 @@ function showClimateEntity(entity_id) {
             subtitle: tempSubtitle,
             on_click: function() {
                 // Always get the latest climate data when clicked
-                let latestClimate = ha_state_dict[entity_id];
+                let latestClimate = entityStateStore.get(entity_id);
                 let latestData = getClimateData(latestClimate);
 
                 if (latestData.hvac_mode === 'heat_cool') {
@@ -3313,25 +3305,14 @@ function showClimateEntity(entity_id) {
                         });
                     }
 
-                    // Subscribe to entity updates
-                    let temp_range_subscription_msg_id = haws.subscribeTrigger({
-                        "type": "subscribe_trigger",
-                        "trigger": {
-                            "platform": "state",
-                            "entity_id": entity_id,
-                        },
-                    }, function(data) {
-                        log_message(`Climate entity update for temperature range menu ${entity_id}`);
-                        // Update the climate entity in the cache
-                        if (data.event && data.event.variables && data.event.variables.trigger && data.event.variables.trigger.to_state) {
-                            let updatedClimate = data.event.variables.trigger.to_state;
-                            ha_state_dict[entity_id] = updatedClimate;
-
-                            // Update menu items directly
-                            updateTempRangeMenuItems(updatedClimate);
+                    // Watch for entity updates
+                    let temp_range_subscription_msg_id = entityStateStore.watch(entity_id, function(updatedClimate) {
+                        if (!updatedClimate) {
+                            return;
                         }
-                    }, function(error) {
-                        log_message(`ENTITY UPDATE ERROR [${entity_id}]: ${JSON.stringify(error)}`);
+                        log_message(`Climate entity update for temperature range menu ${entity_id}`);
+                        // Update menu items directly
+                        updateTempRangeMenuItems(updatedClimate);
                     });
 
                     tempRangeMenu.on('select', function(e) {
@@ -3342,9 +3323,9 @@ function showClimateEntity(entity_id) {
                     });
 
                     tempRangeMenu.on('hide', function() {
-                        // Unsubscribe from entity updates
+                        // Stop watching entity updates
                         if (temp_range_subscription_msg_id) {
-                            haws.unsubscribe(temp_range_subscription_msg_id);
+                            entityStateStore.unwatch(temp_range_subscription_msg_id);
                         }
                     });
 
@@ -3362,7 +3343,7 @@ function showClimateEntity(entity_id) {
             subtitle: climateData.hvac_mode ? ucwords(climateData.hvac_mode.replace('_', ' ')) : 'Unknown',
             on_click: function() {
                 // Always get the latest climate data when clicked
-                let latestClimate = ha_state_dict[entity_id];
+                let latestClimate = entityStateStore.get(entity_id);
                 let latestData = getClimateData(latestClimate);
                 showHvacModeMenu(entity_id, latestData.hvac_mode, latestData.hvac_modes);
             }
@@ -3375,7 +3356,7 @@ function showClimateEntity(entity_id) {
                 subtitle: climateData.fan_mode ? ucwords(climateData.fan_mode.replace('_', ' ')) : 'Unknown',
                 on_click: function() {
                     // Always get the latest climate data when clicked
-                    let latestClimate = ha_state_dict[entity_id];
+                    let latestClimate = entityStateStore.get(entity_id);
                     let latestData = getClimateData(latestClimate);
                     showFanModeMenu(entity_id, latestData.fan_mode, latestData.fan_modes);
                 }
@@ -3389,7 +3370,7 @@ function showClimateEntity(entity_id) {
                 subtitle: climateData.preset_mode ? ucwords(climateData.preset_mode.replace('_', ' ')) : 'None',
                 on_click: function() {
                     // Always get the latest climate data when clicked
-                    let latestClimate = ha_state_dict[entity_id];
+                    let latestClimate = entityStateStore.get(entity_id);
                     let latestData = getClimateData(latestClimate);
                     showPresetModeMenu(entity_id, latestData.preset_mode, latestData.preset_modes);
                 }
@@ -3403,7 +3384,7 @@ function showClimateEntity(entity_id) {
                 subtitle: climateData.swing_mode ? ucwords(climateData.swing_mode.replace('_', ' ')) : 'Unknown',
                 on_click: function() {
                     // Always get the latest climate data when clicked
-                    let latestClimate = ha_state_dict[entity_id];
+                    let latestClimate = entityStateStore.get(entity_id);
                     let latestData = getClimateData(latestClimate);
                     showSwingModeMenu(entity_id, latestData.swing_mode, latestData.swing_modes);
                 }
@@ -3479,25 +3460,14 @@ function showClimateEntity(entity_id) {
             }
         }
 
-        // Subscribe to entity updates
-        subscription_msg_id = haws.subscribeTrigger({
-            "type": "subscribe_trigger",
-            "trigger": {
-                "platform": "state",
-                "entity_id": entity_id,
-            },
-        }, function(data) {
-            log_message(`Climate entity update for ${entity_id}`);
-            // Update the climate entity in the cache
-            if (data.event && data.event.variables && data.event.variables.trigger && data.event.variables.trigger.to_state) {
-                let updatedClimate = data.event.variables.trigger.to_state;
-                ha_state_dict[entity_id] = updatedClimate;
-
-                // Update the menu items directly without redrawing the entire menu
-                updateClimateMenuItems(updatedClimate);
+        // Watch for entity updates
+        subscription_msg_id = entityStateStore.watch(entity_id, function(updatedClimate) {
+            if (!updatedClimate) {
+                return;
             }
-        }, function(error) {
-            log_message(`ENTITY UPDATE ERROR [${entity_id}]: ${JSON.stringify(error)}`);
+            log_message(`Climate entity update for ${entity_id}`);
+            // Update the menu items directly without redrawing the entire menu
+            updateClimateMenuItems(updatedClimate);
         });
 
         // Restore the previously selected index after a short delay
@@ -3526,16 +3496,16 @@ function showClimateEntity(entity_id) {
     });
 
     climateMenu.on('hide', function() {
-        // Unsubscribe from entity updates
+        // Stop watching entity updates
         if (subscription_msg_id) {
-            haws.unsubscribe(subscription_msg_id);
+            entityStateStore.unwatch(subscription_msg_id);
         }
     });
 
     // Helper function to show temperature selection menu
     function showTemperatureMenu(entity_id, mode, current_temp, min_temp, max_temp, step) {
         // Get the latest climate data to ensure we have the most up-to-date values
-        let climate = ha_state_dict[entity_id];
+        let climate = entityStateStore.get(entity_id);
         let climateData = getClimateData(climate);
 
         // Remember which menu item we came from
@@ -3661,25 +3631,14 @@ function showClimateEntity(entity_id) {
             }
         }
 
-        // Subscribe to entity updates
-        let temp_subscription_msg_id = haws.subscribeTrigger({
-            "type": "subscribe_trigger",
-            "trigger": {
-                "platform": "state",
-                "entity_id": entity_id,
-            },
-        }, function(data) {
-            log_message(`Climate entity update for temperature menu ${entity_id}`);
-            // Update the climate entity in the cache
-            if (data.event && data.event.variables && data.event.variables.trigger && data.event.variables.trigger.to_state) {
-                let updatedClimate = data.event.variables.trigger.to_state;
-                ha_state_dict[entity_id] = updatedClimate;
-
-                // Update menu items directly
-                updateTemperatureMenuItems(updatedClimate);
+        // Watch for entity updates
+        let temp_subscription_msg_id = entityStateStore.watch(entity_id, function(updatedClimate) {
+            if (!updatedClimate) {
+                return;
             }
-        }, function(error) {
-            log_message(`ENTITY UPDATE ERROR [${entity_id}]: ${JSON.stringify(error)}`);
+            log_message(`Climate entity update for temperature menu ${entity_id}`);
+            // Update menu items directly
+            updateTemperatureMenuItems(updatedClimate);
         });
 
         tempMenu.on('select', function(e) {
@@ -3690,9 +3649,9 @@ function showClimateEntity(entity_id) {
         });
 
         tempMenu.on('hide', function() {
-            // Unsubscribe from entity updates
+            // Stop watching entity updates
             if (temp_subscription_msg_id) {
-                haws.unsubscribe(temp_subscription_msg_id);
+                entityStateStore.unwatch(temp_subscription_msg_id);
             }
 
             // Restore the selection in the parent menu
@@ -3705,7 +3664,7 @@ function showClimateEntity(entity_id) {
     // Helper function to show HVAC mode selection menu
     function showHvacModeMenu(entity_id, current_mode, available_modes) {
         // Get the latest climate data to ensure we have the most up-to-date values
-        let climate = ha_state_dict[entity_id];
+        let climate = entityStateStore.get(entity_id);
         let climateData = getClimateData(climate);
 
         // Remember which menu item we came from
@@ -3759,38 +3718,27 @@ function showClimateEntity(entity_id) {
         // Scroll to the current mode
         modeMenu.selection(0, currentIndex);
 
-        // Subscribe to entity updates
-        let hvac_subscription_msg_id = haws.subscribeTrigger({
-            "type": "subscribe_trigger",
-            "trigger": {
-                "platform": "state",
-                "entity_id": entity_id,
-            },
-        }, function(data) {
+        // Watch for entity updates
+        let hvac_subscription_msg_id = entityStateStore.watch(entity_id, function(updatedClimate) {
+            if (!updatedClimate) {
+                return;
+            }
             log_message(`Climate entity update for HVAC mode menu ${entity_id}`);
-            // Update the climate entity in the cache
-            if (data.event && data.event.variables && data.event.variables.trigger && data.event.variables.trigger.to_state) {
-                let updatedClimate = data.event.variables.trigger.to_state;
-                ha_state_dict[entity_id] = updatedClimate;
-
-                // Get updated climate data
-                let updatedData = getClimateData(updatedClimate);
+            // Get updated climate data
+            let updatedData = getClimateData(updatedClimate);
 
-                // Update menu items to reflect current state
-                for (let i = 0; i < available_modes.length; i++) {
-                    let mode = available_modes[i];
-                    let isCurrentMode = mode === updatedData.hvac_mode;
-
-                    modeMenu.item(0, i, {
-                        title: ucwords(mode.replace('_', ' ')),
-                        subtitle: isCurrentMode ? 'Current' : '',
-                        mode: mode,
-                        on_click: modeMenu.items(0)[i].on_click
-                    });
-                }
+            // Update menu items to reflect current state
+            for (let i = 0; i < available_modes.length; i++) {
+                let mode = available_modes[i];
+                let isCurrentMode = mode === updatedData.hvac_mode;
+
+                modeMenu.item(0, i, {
+                    title: ucwords(mode.replace('_', ' ')),
+                    subtitle: isCurrentMode ? 'Current' : '',
+                    mode: mode,
+                    on_click: modeMenu.items(0)[i].on_click
+                });
             }
-        }, function(error) {
-            log_message(`ENTITY UPDATE ERROR [${entity_id}]: ${JSON.stringify(error)}`);
         });
 
         modeMenu.on('select', function(e) {
@@ -3801,9 +3749,9 @@ function showClimateEntity(entity_id) {
         });
 
         modeMenu.on('hide', function() {
-            // Unsubscribe from entity updates
+            // Stop watching entity updates
             if (hvac_subscription_msg_id) {
-                haws.unsubscribe(hvac_subscription_msg_id);
+                entityStateStore.unwatch(hvac_subscription_msg_id);
             }
 
             // Restore the selection in the parent menu
@@ -3816,7 +3764,7 @@ function showClimateEntity(entity_id) {
     // Helper function to show fan mode selection menu
     function showFanModeMenu(entity_id, current_mode, available_modes) {
         // Get the latest climate data to ensure we have the most up-to-date values
-        let climate = ha_state_dict[entity_id];
+        let climate = entityStateStore.get(entity_id);
         let climateData = getClimateData(climate);
 
         // Remember which menu item we came from
@@ -3870,38 +3818,27 @@ function showClimateEntity(entity_id) {
         // Scroll to the current mode
         modeMenu.selection(0, currentIndex);
 
-        // Subscribe to entity updates
-        let fan_subscription_msg_id = haws.subscribeTrigger({
-            "type": "subscribe_trigger",
-            "trigger": {
-                "platform": "state",
-                "entity_id": entity_id,
-            },
-        }, function(data) {
+        // Watch for entity updates
+        let fan_subscription_msg_id = entityStateStore.watch(entity_id, function(updatedClimate) {
+            if (!updatedClimate) {
+                return;
+            }
             log_message(`Climate entity update for fan mode menu ${entity_id}`);
-            // Update the climate entity in the cache
-            if (data.event && data.event.variables && data.event.variables.trigger && data.event.variables.trigger.to_state) {
-                let updatedClimate = data.event.variables.trigger.to_state;
-                ha_state_dict[entity_id] = updatedClimate;
-
-                // Get updated climate data
-                let updatedData = getClimateData(updatedClimate);
+            // Get updated climate data
+            let updatedData = getClimateData(updatedClimate);
 
-                // Update menu items to reflect current state
-                for (let i = 0; i < available_modes.length; i++) {
-                    let mode = available_modes[i];
-                    let isCurrentMode = mode === updatedData.fan_mode;
-
-                    modeMenu.item(0, i, {
-                        title: ucwords(mode.replace('_', ' ')),
-                        subtitle: isCurrentMode ? 'Current' : '',
-                        mode: mode,
-                        on_click: modeMenu.items(0)[i].on_click
-                    });
-                }
+            // Update menu items to reflect current state
+            for (let i = 0; i < available_modes.length; i++) {
+                let mode = available_modes[i];
+                let isCurrentMode = mode === updatedData.fan_mode;
+
+                modeMenu.item(0, i, {
+                    title: ucwords(mode.replace('_', ' ')),
+                    subtitle: isCurrentMode ? 'Current' : '',
+                    mode: mode,
+                    on_click: modeMenu.items(0)[i].on_click
+                });
             }
-        }, function(error) {
-            log_message(`ENTITY UPDATE ERROR [${entity_id}]: ${JSON.stringify(error)}`);
         });
 
         modeMenu.on('select', function(e) {
@@ -3912,9 +3849,9 @@ function showClimateEntity(entity_id) {
         });
 
         modeMenu.on('hide', function() {
-            // Unsubscribe from entity updates
+            // Stop watching entity updates
             if (fan_subscription_msg_id) {
-                haws.unsubscribe(fan_subscription_msg_id);
+                entityStateStore.unwatch(fan_subscription_msg_id);
             }
 
             // Restore the selection in the parent menu
@@ -3927,7 +3864,7 @@ function showClimateEntity(entity_id) {
     // Helper function to show preset mode selection menu
     function showPresetModeMenu(entity_id, current_mode, available_modes) {
         // Get the latest climate data to ensure we have the most up-to-date values
-        let climate = ha_state_dict[entity_id];
+        let climate = entityStateStore.get(entity_id);
         let climateData = getClimateData(climate);
 
         // Remember which menu item we came from
@@ -3981,38 +3918,27 @@ function showClimateEntity(entity_id) {
         // Scroll to the current mode
         modeMenu.selection(0, currentIndex);
 
-        // Subscribe to entity updates
-        let preset_subscription_msg_id = haws.subscribeTrigger({
-            "type": "subscribe_trigger",
-            "trigger": {
-                "platform": "state",
-                "entity_id": entity_id,
-            },
-        }, function(data) {
+        // Watch for entity updates
+        let preset_subscription_msg_id = entityStateStore.watch(entity_id, function(updatedClimate) {
+            if (!updatedClimate) {
+                return;
+            }
             log_message(`Climate entity update for preset mode menu ${entity_id}`);
-            // Update the climate entity in the cache
-            if (data.event && data.event.variables && data.event.variables.trigger && data.event.variables.trigger.to_state) {
-                let updatedClimate = data.event.variables.trigger.to_state;
-                ha_state_dict[entity_id] = updatedClimate;
-
-                // Get updated climate data
-                let updatedData = getClimateData(updatedClimate);
+            // Get updated climate data
+            let updatedData = getClimateData(updatedClimate);
 
-                // Update menu items to reflect current state
-                for (let i = 0; i < available_modes.length; i++) {
-                    let mode = available_modes[i];
-                    let isCurrentMode = mode === updatedData.preset_mode;
-
-                    modeMenu.item(0, i, {
-                        title: ucwords(mode.replace('_', ' ')),
-                        subtitle: isCurrentMode ? 'Current' : '',
-                        mode: mode,
-                        on_click: modeMenu.items(0)[i].on_click
-                    });
-                }
+            // Update menu items to reflect current state
+            for (let i = 0; i < available_modes.length; i++) {
+                let mode = available_modes[i];
+                let isCurrentMode = mode === updatedData.preset_mode;
+
+                modeMenu.item(0, i, {
+                    title: ucwords(mode.replace('_', ' ')),
+                    subtitle: isCurrentMode ? 'Current' : '',
+                    mode: mode,
+                    on_click: modeMenu.items(0)[i].on_click
+                });
             }
-        }, function(error) {
-            log_message(`ENTITY UPDATE ERROR [${entity_id}]: ${JSON.stringify(error)}`);
         });
 
         modeMenu.on('select', function(e) {
@@ -4023,9 +3949,9 @@ function showClimateEntity(entity_id) {
         });
 
         modeMenu.on('hide', function() {
-            // Unsubscribe from entity updates
+            // Stop watching entity updates
             if (preset_subscription_msg_id) {
-                haws.unsubscribe(preset_subscription_msg_id);
+                entityStateStore.unwatch(preset_subscription_msg_id);
             }
 
             // Restore the selection in the parent menu
@@ -4038,7 +3964,7 @@ function showClimateEntity(entity_id) {
     // Helper function to show swing mode selection menu
     function showSwingModeMenu(entity_id, current_mode, available_modes) {
         // Get the latest climate data to ensure we have the most up-to-date values
-        let climate = ha_state_dict[entity_id];
+        let climate = entityStateStore.get(entity_id);
         let climateData = getClimateData(climate);
 
         // Remember which menu item we came from
@@ -4092,38 +4018,27 @@ function showClimateEntity(entity_id) {
         // Scroll to the current mode
         modeMenu.selection(0, currentIndex);
 
-        // Subscribe to entity updates
-        let swing_subscription_msg_id = haws.subscribeTrigger({
-            "type": "subscribe_trigger",
-            "trigger": {
-                "platform": "state",
-                "entity_id": entity_id,
-            },
-        }, function(data) {
+        // Watch for entity updates
+        let swing_subscription_msg_id = entityStateStore.watch(entity_id, function(updatedClimate) {
+            if (!updatedClimate) {
+                return;
+            }
             log_message(`Climate entity update for swing mode menu ${entity_id}`);
-            // Update the climate entity in the cache
-            if (data.event && data.event.variables && data.event.variables.trigger && data.event.variables.trigger.to_state) {
-                let updatedClimate = data.event.variables.trigger.to_state;
-                ha_state_dict[entity_id] = updatedClimate;
-
-                // Get updated climate data
-                let updatedData = getClimateData(updatedClimate);
+            // Get updated climate data
+            let updatedData = getClimateData(updatedClimate);
 
-                // Update menu items to reflect current state
-                for (let i = 0; i < available_modes.length; i++) {
-                    let mode = available_modes[i];
-                    let isCurrentMode = mode === updatedData.swing_mode;
-
-                    modeMenu.item(0, i, {
-                        title: ucwords(mode.replace('_', ' ')),
-                        subtitle: isCurrentMode ? 'Current' : '',
-                        mode: mode,
-                        on_click: modeMenu.items(0)[i].on_click
-                    });
-                }
+            // Update menu items to reflect current state
+            for (let i = 0; i < available_modes.length; i++) {
+                let mode = available_modes[i];
+                let isCurrentMode = mode === updatedData.swing_mode;
+
+                modeMenu.item(0, i, {
+                    title: ucwords(mode.replace('_', ' ')),
+                    subtitle: isCurrentMode ? 'Current' : '',
+                    mode: mode,
+                    on_click: modeMenu.items(0)[i].on_click
+                });
             }
-        }, function(error) {
-            log_message(`ENTITY UPDATE ERROR [${entity_id}]: ${JSON.stringify(error)}`);
         });
 
         modeMenu.on('select', function(e) {
@@ -4134,9 +4049,9 @@ function showClimateEntity(entity_id) {
         });
 
         modeMenu.on('hide', function() {
-            // Unsubscribe from entity updates
+            // Stop watching entity updates
             if (swing_subscription_msg_id) {
-                haws.unsubscribe(swing_subscription_msg_id);
+                entityStateStore.unwatch(swing_subscription_msg_id);
             }
 
             // Restore the selection in the parent menu
@@ -4150,10 +4065,10 @@ function showClimateEntity(entity_id) {
 }
 
 function showLightEntity(entity_id) {
-    let light = ha_state_dict[entity_id],
+    let light = entityStateStore.get(entity_id),
         subscription_msg_id = null;
     if (!light) {
-        throw new Error(`Light entity ${entity_id} not found in ha_state_dict`);
+        throw new Error(`Light entity ${entity_id} not found in entity store`);
     }
 
     log_message(`Showing light entity ${entity_id}`, JSON.stringify(light, null, 4));
@@ -4401,7 +4316,7 @@ function showLightEntity(entity_id) {
     // Helper function to show brightness selection menu
     function showBrightnessMenu(entity_id, current_brightness) {
         // Get the latest light data
-        let light = ha_state_dict[entity_id];
+        let light = entityStateStore.get(entity_id);
         let lightData = getLightData(light);
 
         // Remember which menu item we came from
@@ -4521,37 +4436,26 @@ function showLightEntity(entity_id) {
             sliderFg.size(new Vector(sliderWidth, 20));
         }
 
-        // Subscribe to entity updates
-        let brightness_subscription_msg_id = haws.subscribeTrigger({
-            "type": "subscribe_trigger",
-            "trigger": {
-                "platform": "state",
-                "entity_id": entity_id,
-            },
-        }, function(data) {
+        // Watch for entity updates
+        let brightness_subscription_msg_id = entityStateStore.watch(entity_id, function(updatedLight) {
+            if (!updatedLight) {
+                return;
+            }
             log_message(`Light entity update for brightness menu ${entity_id}`);
-            // Update the light entity in the cache
-            if (data.event && data.event.variables && data.event.variables.trigger && data.event.variables.trigger.to_state) {
-                let updatedLight = data.event.variables.trigger.to_state;
-                ha_state_dict[entity_id] = updatedLight;
-
-                // Get updated light data
-                let updatedData = getLightData(updatedLight);
-
-                // Update the brightness value
-                if (updatedData.is_on) {
-                    current_brightness = updatedData.brightnessPerc;
-                    updateBrightnessUI();
-                }
+            // Get updated light data
+            let updatedData = getLightData(updatedLight);
+
+            // Update the brightness value
+            if (updatedData.is_on) {
+                current_brightness = updatedData.brightnessPerc;
+                updateBrightnessUI();
             }
-        }, function(error) {
-            log_message(`ENTITY UPDATE ERROR [${entity_id}]: ${JSON.stringify(error)}`);
         });
 
         brightnessWindow.on('hide', function() {
-            // Unsubscribe from entity updates
+            // Stop watching entity updates
             if (brightness_subscription_msg_id) {
-                haws.unsubscribe(brightness_subscription_msg_id);
+                entityStateStore.unwatch(brightness_subscription_msg_id);
             }
 
             // Restore the selection in the parent menu
@@ -4564,7 +4468,7 @@ function showLightEntity(entity_id) {
     // Helper function to show color temperature selection menu
     function showColorTempMenu(entity_id, current_temp, min_temp, max_temp) {
         // Get the latest light data
-        let light = ha_state_dict[entity_id];
+        let light = entityStateStore.get(entity_id);
         let lightData = getLightData(light);
 
         // Remember which menu item we came from
@@ -4695,37 +4599,26 @@ function showLightEntity(entity_id) {
             sliderFg.size(new Vector(sliderWidth, 20));
         }
 
-        // Subscribe to entity updates
-        let temp_subscription_msg_id = haws.subscribeTrigger({
-            "type": "subscribe_trigger",
-            "trigger": {
-                "platform": "state",
-                "entity_id": entity_id,
-            },
-        }, function(data) {
+        // Watch for entity updates
+        let temp_subscription_msg_id = entityStateStore.watch(entity_id, function(updatedLight) {
+            if (!updatedLight) {
+                return;
+            }
             log_message(`Light entity update for color temp menu ${entity_id}`);
-            // Update the light entity in the cache
-            if (data.event && data.event.variables && data.event.variables.trigger && data.event.variables.trigger.to_state) {
-                let updatedLight = data.event.variables.trigger.to_state;
-                ha_state_dict[entity_id] = updatedLight;
-
-                // Get updated light data
-                let updatedData = getLightData(updatedLight);
-
-                // Update the color temperature value
-                if (updatedData.is_on && updatedData.color_temp_kelvin) {
-                    current_temp = updatedData.color_temp_kelvin;
-                    updateTempUI();
-                }
+            // Get updated light data
+            let updatedData = getLightData(updatedLight);
+
+            // Update the color temperature value
+            if (updatedData.is_on && updatedData.color_temp_kelvin) {
+                current_temp = updatedData.color_temp_kelvin;
+                updateTempUI();
             }
-        }, function(error) {
-            log_message(`ENTITY UPDATE ERROR [${entity_id}]: ${JSON.stringify(error)}`);
         });
 
         tempWindow.on('hide', function() {
-            // Unsubscribe from entity updates
+            // Stop watching entity updates
             if (temp_subscription_msg_id) {
-                haws.unsubscribe(temp_subscription_msg_id);
+                entityStateStore.unwatch(temp_subscription_msg_id);
             }
 
             // Restore the selection in the parent menu
@@ -4738,7 +4631,7 @@ function showLightEntity(entity_id) {
     // Helper function to show color selection menu with a colorful slider
     function showColorMenu(entity_id, current_color) {
         // Get the latest light data
-        let light = ha_state_dict[entity_id];
+        let light = entityStateStore.get(entity_id);
         let lightData = getLightData(light);
 
         // Remember which menu item we came from
@@ -5042,31 +4935,20 @@ function showLightEntity(entity_id) {
             }
         }
 
-        // Subscribe to entity updates
-        let color_subscription_msg_id = haws.subscribeTrigger({
-            "type": "subscribe_trigger",
-            "trigger": {
-                "platform": "state",
-                "entity_id": entity_id,
-            },
-        }, function(data) {
-            log_message(`Light entity update for color menu ${entity_id}`);
-            // Update the light entity in the cache
-            if (data.event && data.event.variables && data.event.variables.trigger && data.event.variables.trigger.to_state) {
-                let updatedLight = data.event.variables.trigger.to_state;
-                ha_state_dict[entity_id] = updatedLight;
-
-                // Update menu items directly
-                updateColorMenuItems(updatedLight);
+        // Watch for entity updates
+        let color_subscription_msg_id = entityStateStore.watch(entity_id, function(updatedLight) {
+            if (!updatedLight) {
+                return;
             }
-        }, function(error) {
-            log_message(`ENTITY UPDATE ERROR [${entity_id}]: ${JSON.stringify(error)}`);
+            log_message(`Light entity update for color menu ${entity_id}`);
+            // Update menu items directly
+            updateColorMenuItems(updatedLight);
         });
 
         colorMenu.on('hide', function() {
-            // Unsubscribe from entity updates
+            // Stop watching entity updates
             if (color_subscription_msg_id) {
-                haws.unsubscribe(color_subscription_msg_id);
+                entityStateStore.unwatch(color_subscription_msg_id);
             }
 
             // Restore the selection in the parent menu
@@ -5086,7 +4968,7 @@ function showLightEntity(entity_id) {
     // Helper function to show effect selection menu
     function showEffectMenu(entity_id, current_effect, effect_list) {
         // Get the latest light data
-        let light = ha_state_dict[entity_id];
+        let light = entityStateStore.get(entity_id);
         let lightData = getLightData(light);
 
         // Remember which menu item we came from
@@ -5180,31 +5062,20 @@ function showLightEntity(entity_id) {
             }
         }
 
-        // Subscribe to entity updates
-        let effect_subscription_msg_id = haws.subscribeTrigger({
-            "type": "subscribe_trigger",
-            "trigger": {
-                "platform": "state",
-                "entity_id": entity_id,
-            },
-        }, function(data) {
-            log_message(`Light entity update for effect menu ${entity_id}`);
-            // Update the light entity in the cache
-            if (data.event && data.event.variables && data.event.variables.trigger && data.event.variables.trigger.to_state) {
-                let updatedLight = data.event.variables.trigger.to_state;
-                ha_state_dict[entity_id] = updatedLight;
-
-                // Update menu items directly
-                updateEffectMenuItems(updatedLight);
+        // Watch for entity updates
+        let effect_subscription_msg_id = entityStateStore.watch(entity_id, function(updatedLight) {
+            if (!updatedLight) {
+                return;
             }
-        }, function(error) {
-            log_message(`ENTITY UPDATE ERROR [${entity_id}]: ${JSON.stringify(error)}`);
+            log_message(`Light entity update for effect menu ${entity_id}`);
+            // Update menu items directly
+            updateEffectMenuItems(updatedLight);
         });
 
         effectMenu.on('hide', function() {
-            // Unsubscribe from entity updates
+            // Stop watching entity updates
             if (effect_subscription_msg_id) {
-                haws.unsubscribe(effect_subscription_msg_id);
+                entityStateStore.unwatch(effect_subscription_msg_id);
             }
 
             // Restore the selection in the parent menu
@@ -5235,32 +5106,21 @@ function showLightEntity(entity_id) {
         lightMenu.items(0, []);
 
         // Get the latest light data
-        light = ha_state_dict[entity_id];
+        light = entityStateStore.get(entity_id);
         lightData = getLightData(light);
         features = supported_features(light);
 
         // Update menu items
         updateLightMenuItems(light);
 
-        // Subscribe to entity updates
-        subscription_msg_id = haws.subscribeTrigger({
-            "type": "subscribe_trigger",
-            "trigger": {
-                "platform": "state",
-                "entity_id": entity_id,
-            },
-        }, function(data) {
-            log_message(`Light entity update for ${entity_id}`);
-            // Update the light entity in the cache
-            if (data.event && data.event.variables && data.event.variables.trigger && data.event.variables.trigger.to_state) {
-                let updatedLight = data.event.variables.trigger.to_state;
-                ha_state_dict[entity_id] = updatedLight;
-
-                // Update the menu items directly without redrawing the entire menu
-                updateLightMenuItems(updatedLight);
+        // Watch for entity updates
+        subscription_msg_id = entityStateStore.watch(entity_id, function(updatedLight) {
+            if (!updatedLight) {
+                return;
             }
-        }, function(error) {
-            log_message(`ENTITY UPDATE ERROR [${entity_id}]: ${JSON.stringify(error)}`);
+            log_message(`Light entity update for ${entity_id}`);
+            // Update the menu items directly without redrawing the entire menu
+            updateLightMenuItems(updatedLight);
         });
 
         // Restore the previously selected index
@@ -5278,9 +5138,9 @@ function showLightEntity(entity_id) {
     });
 
     lightMenu.on('hide', function() {
-        // Unsubscribe from entity updates
+        // Stop watching entity updates
         if (subscription_msg_id) {
-            haws.unsubscribe(subscription_msg_id);
+            entityStateStore.unwatch(subscription_msg_id);
         }
     });
 
@@ -5300,9 +5160,9 @@ let menuSelections = {
 };
 
 function showEntityMenu(entity_id) {
-    let entity = ha_state_dict[entity_id];
+    let entity = entityStateStore.get(entity_id);
     if(!entity){
-        throw new Error(`Entity ${entity_id} not found in ha_state_dict`);
+        throw new Error(`Entity ${entity_id} not found in entity store`);
     }
 
     // Set Menu colors
@@ -5816,26 +5676,21 @@ function showEntityMenu(entity_id) {
     _renderPinnedBtn();
 
     showEntityMenu.on('show', function(){
-        msg_id = haws.subscribeTrigger({
-            "type": "subscribe_trigger",
-            "trigger": {
-                "platform": "state",
-                "entity_id": entity.entity_id,
-            },
-        }, function(data) {
+        msg_id = entityStateStore.watch(entity.entity_id, function(updatedEntity) {
+            if (!updatedEntity) {
+                return;
+            }
             // log_message(`Entity update for ${entity.entity_id}`);
 
             showEntityMenu.item(0, stateIndex, {
                 title: 'State',
-                subtitle: `${data.event.variables.trigger.to_state.state}` + (entity.attributes.unit_of_measurement ? ` ${entity.attributes.unit_of_measurement}` : '')
+                subtitle: `${updatedEntity.state}` + (entity.attributes.unit_of_measurement ? ` ${entity.attributes.unit_of_measurement}` : '')
             });
-        }, function(error) {
-            log_message(`ENTITY UPDATE ERROR [${entity.entity_id}]: ` + JSON.stringify(error));
         });
     });
     showEntityMenu.on('close', function(){
         if(msg_id) {
-            haws.unsubscribe(msg_id);
+            entityStateStore.unwatch(msg_id);
         }
     });
 
@@ -5843,9 +5698,9 @@ function showEntityMenu(entity_id) {
 }
 
 function showEntityAttributesMenu(entity_id) {
-    let entity = ha_state_dict[entity_id];
+    let entity = entityStateStore.get(entity_id);
     if(!entity){
-        throw new Error(`Entity ${entity_id} not found in ha_state_dict`);
+        throw new Error(`Entity ${entity_id} not found in entity store`);
     }
 
     // Create a menu for the attributes
@@ -5883,39 +5738,29 @@ function showEntityAttributesMenu(entity_id) {
             });
         }
 
-        // Subscribe to entity updates
-        msg_id = haws.subscribeTrigger({
-            "type": "subscribe_trigger",
-            "trigger": {
-                "platform": "state",
-                "entity_id": entity_id,
-            },
-        }, function(data) {
-            if (data.event && data.event.variables && data.event.variables.trigger && data.event.variables.trigger.to_state) {
-                let updatedEntity = data.event.variables.trigger.to_state;
-                ha_state_dict[entity_id] = updatedEntity;
-
-                // Update all attribute values
-                for (let i = 0; i < attributesMenu.items(0).length; i++) {
-                    const item = attributesMenu.item(0, i);
-                    if (item.attribute_name && updatedEntity.attributes[item.attribute_name] !== undefined) {
-                        attributesMenu.item(0, i, {
-                            title: item.attribute_name,
-                            subtitle: updatedEntity.attributes[item.attribute_name],
-                            attribute_name: item.attribute_name
-                        });
-                    }
+        // Watch for entity updates
+        msg_id = entityStateStore.watch(entity_id, function(updatedEntity) {
+            if (!updatedEntity) {
+                return;
+            }
+            // Update all attribute values
+            for (let i = 0; i < attributesMenu.items(0).length; i++) {
+                const item = attributesMenu.item(0, i);
+                if (item.attribute_name && updatedEntity.attributes[item.attribute_name] !== undefined) {
+                    attributesMenu.item(0, i, {
+                        title: item.attribute_name,
+                        subtitle: updatedEntity.attributes[item.attribute_name],
+                        attribute_name: item.attribute_name
+                    });
                 }
             }
-        }, function(error) {
-            log_message(`ENTITY UPDATE ERROR [${entity_id}]: ${JSON.stringify(error)}`);
         });
     });
 
     attributesMenu.on('hide', function() {
-        // Unsubscribe from entity updates when menu is closed
+        // Stop watching entity updates when menu is closed
         if (msg_id) {
-            haws.unsubscribe(msg_id);
+            entityStateStore.unwatch(msg_id);
         }
     });
 
@@ -5943,7 +5788,7 @@ function showEntityDomainsFromList(entity_id_list, title) {
         let domainEntities = {};
         let missingEntities = [];
         for(let entity_id of entity_id_list) {
-            let entity = ha_state_dict[entity_id];
+            let entity = entityStateStore.get(entity_id);
             if(!entity) {
                 missingEntities.push(entity_id);
                 continue;
@@ -5964,7 +5809,7 @@ function showEntityDomainsFromList(entity_id_list, title) {
         }
 
         if (missingEntities.length > 0) {
-            log_message(`showEntityDomainsFromList: WARNING - ${missingEntities.length} entities missing from ha_state_dict: ${missingEntities.join(', ')}`);
+            log_message(`showEntityDomainsFromList: WARNING - ${missingEntities.length} entities missing from entity store: ${missingEntities.join(', ')}`);
         }
 
         // sort domain list
@@ -6152,7 +5997,7 @@ function handleEntityLongPress(entity_id) {
             });
     }
     else if (domain === "lock") {
-        let entity = ha_state_dict[entity_id];
+        let entity = entityStateStore.get(entity_id);
         if (!entity) {
             log_message(`handleEntityLongPress: entity ${entity_id} not found in state dict`);
             return;
@@ -6187,7 +6032,7 @@ function handleEntityLongPress(entity_id) {
             });
     }
     else if (domain === "vacuum") {
-        let entity = ha_state_dict[entity_id];
+        let entity = entityStateStore.get(entity_id);
         if (!entity) {
             log_message(`handleEntityLongPress: entity ${entity_id} not found in state dict`);
             return;
@@ -6309,20 +6154,17 @@ function showToDoLists() {
     // Function to get sorted todo lists
     function getSortedTodoLists() {
         let todoLists = [];
-        for(let entity_id in ha_state_dict) {
-            if(entity_id.split('.')[0] !== "todo") {
+        for(let entity_id of entityStateStore.idsForDomain('todo')) {
+            let entity = entityStateStore.get(entity_id);
+            if(entity.state === "unavailable" || entity.state === "unknown") {
                 continue;
             }
 
-            if(ha_state_dict[entity_id].state === "unavailable" || ha_state_dict[entity_id].state === "unknown") {
+            if(!entity.attributes || !entity.attributes.friendly_name) {
                 continue;
             }
 
-            if(!ha_state_dict[entity_id].attributes || !ha_state_dict[entity_id].attributes.friendly_name) {
-                continue;
-            }
-
-            todoLists.push(ha_state_dict[entity_id]);
+            todoLists.push(entity);
         }
 
         // sort todoLists alphabetically by friendly_name
@@ -6375,11 +6217,12 @@ function showToDoLists() {
                 "type": "todo/item/subscribe",
                 "entity_id": entity_id
             }, function(data) {
-                // When items change, update the count in ha_state_dict
+                // When items change, update the count in the entity store
                 if (data.event && data.event.items) {
                     let itemCount = data.event.items.length;
-                    if (ha_state_dict[entity_id]) {
-                        ha_state_dict[entity_id].state = itemCount;
+                    let todoList = entityStateStore.get(entity_id);
+                    if (todoList) {
+                        entityStateStore.set(Object.assign({}, todoList, { state: itemCount }));
                     }
                     // Update the menu to reflect the new count
                     updateMenuItems();
@@ -6408,11 +6251,11 @@ function showToDoLists() {
 
 // show a specific todo list
 function showToDoList(entity_id) {
-    let todoList = ha_state_dict[entity_id];
+    let todoList = entityStateStore.get(entity_id);
     log_message(`showToDoList: ${entity_id}`);
     if(!todoList) {
-        log_message(`showToDoList: ${entity_id} not found in ha_state_dict`);
-        throw new Error(`ToDo list ${entity_id} not found in ha_state_dict`);
+        log_message(`showToDoList: ${entity_id} not found in entity store`);
+        throw new Error(`ToDo list ${entity_id} not found in entity store`);
     }
 
     let todoListMenu = new UI.Menu({
@@ -7323,7 +7166,7 @@ function showEntityList(title, entity_id_list = false, ignoreEntityCache = true,
         }]
     });
 
-    entityListMenu.subscription_id = null;
+    entityListMenu.watch_id = null;
     entityListMenu.current_page = null;
 
     // Create a RelativeTimeUpdater to keep entity subtitles updated
@@ -7337,9 +7180,12 @@ function showEntityList(title, entity_id_list = false, ignoreEntityCache = true,
 
     entityListMenu.on('hide', function(e) {
         log_message(`showEntityList (title=${title}): hide event called`);
-        if(entityListMenu.subscription_id) {
-            haws.unsubscribe(entityListMenu.subscription_id);
+        if(entityListMenu.watch_id) {
+            entityStateStore.unwatch(entityListMenu.watch_id);
+            entityListMenu.watch_id = null;
         }
+        clearTimeout(entityListMenu.render_timer);
+        entityListMenu.render_timer = null;
         // Pause relative time updates when menu is hidden
         if (relativeTimeUpdater) {
             relativeTimeUpdater.pause();
@@ -7379,36 +7225,42 @@ function showEntityList(title, entity_id_list = false, ignoreEntityCache = true,
         // Check if we're staying on the same page
         let stayingOnSamePage = (entityListMenu.current_page === pageNumber);
 
-        // Unsubscribe from previous subscription if exists
-        if(entityListMenu.subscription_id) {
-            haws.unsubscribe(entityListMenu.subscription_id);
-            entityListMenu.subscription_id = null;
+        // Stop watching the previous page
+        if(entityListMenu.watch_id) {
+            entityStateStore.unwatch(entityListMenu.watch_id);
+            entityListMenu.watch_id = null;
         }
-
-        // Determine which entity IDs to subscribe to
-        let entitiesToSubscribe = entity_id_list ? entity_id_list.slice() : [];
+        clearTimeout(entityListMenu.render_timer);
+        entityListMenu.render_timer = null;
 
         // Filter out ignored domains if skipIgnoredDomains is true
-        if (skipIgnoredDomains && ignore_domains && ignore_domains.length > 0) {
-            entitiesToSubscribe = entitiesToSubscribe.filter(function(entity_id) {
+        function isListed(entity_id) {
+            if (skipIgnoredDomains && ignore_domains && ignore_domains.length > 0) {
                 const [domain] = entity_id.split('.');
                 return ignore_domains.indexOf(domain) === -1;
-            });
+            }
+            return true;
         }
 
+        // Determine which entity IDs to watch
+        let entitiesToSubscribe = (entity_id_list ? entity_id_list.slice() : entityStateStore.ids())
+            .filter(isListed);
+
         if (entitiesToSubscribe.length === 0) {
             log_message('No entities to subscribe to');
             entityListMenu.section(0).title = 'No entities';
             return;
         }
 
-        let prev_title = entityListMenu.section(0).title;
-        entityListMenu.section(0).title = 'updating ...';
-
-        // Local state cache for this subscription
+        // States of the listed entities, read from the entity store
         let entityStates = {};
         let renderedEntityIds = {};
-        let initialSnapshotReceived = false;
+        for (let entity_id of entitiesToSubscribe) {
+            let entity = entityStateStore.get(entity_id);
+            if (entity) {
+                entityStates[entity_id] = entity;
+            }
+        }
 
         // Clear and recreate the RelativeTimeUpdater for this page
         if (relativeTimeUpdater) {
@@ -7439,17 +7291,6 @@ function showEntityList(title, entity_id_list = false, ignoreEntityCache = true,
             });
         }
 
-        // Helper to convert subscribeEntities format to standard entity format
-        function convertEntityData(entity_id, data) {
-            return {
-                entity_id: entity_id,
-                state: data.s,
-                attributes: data.a || {},
-                context: data.c,
-                last_changed: data.lc ? new Date(data.lc * 1000).toISOString() : new Date().toISOString()
-            };
-        }
-
         // Helper to render the menu from entityStates
         function renderMenu() {
             // Convert entityStates to array for sorting/pagination
@@ -7616,77 +7457,29 @@ function showEntityList(title, entity_id_list = false, ignoreEntityCache = true,
             }
         }
 
-        log_message(`Setting up subscribeEntities for ${entitiesToSubscribe.length} entities: ${entitiesToSubscribe.join(', ')}`);
-        entityListMenu.subscription_id = haws.subscribeEntities(entitiesToSubscribe, function(data) {
-            // log_message(`subscribeEntities event: ${JSON.stringify(data)}`, JSON.stringify(data, null, 4));
-            let ev = data.event || {};
+        renderMenu();
 
-            // Debug logging for subscription events
-            if (ev.a) {
-                log_message(`subscribeEntities: received ${Object.keys(ev.a).length} added entities`);
-            }
-            if (ev.c) {
-                log_message(`subscribeEntities: received ${Object.keys(ev.c).length} changed entities`);
-            }
-            if (ev.r) {
-                log_message(`subscribeEntities: received ${Object.keys(ev.r).length} removed entities: ${Object.keys(ev.r).join(', ')}`);
+        // Without a list every entity is shown, including the ones added after the list opened
+        entityListMenu.watch_id = entityStateStore.watch(entity_id_list ? entitiesToSubscribe : null, function(entity, entity_id) {
+            if (!isListed(entity_id)) {
+                return;
             }
-
-            // Handle added entities (initial snapshot)
-            if (ev.a) {
-                for (let entity_id in ev.a) {
-                    let entityData = convertEntityData(entity_id, ev.a[entity_id]);
-                    entityStates[entity_id] = entityData;
-                    ha_state_dict[entity_id] = entityData;
-                }
-
-                // On initial snapshot, render the full menu
-                if (!initialSnapshotReceived) {
-                    initialSnapshotReceived = true;
-                    entityListMenu.section(0).title = prev_title;
+            const isKnown = entity_id in entityStates;
+            if (entity) {
+                entityStates[entity_id] = entity;
+            } else {
+                delete entityStates[entity_id];
+            }
+            log_message(`Entity update for ${entity_id}: ${entity ? entity.state : 'removed'}`);
+            if (entity && isKnown) {
+                updateEntityInMenu(entity_id);
+            } else if (!entityListMenu.render_timer) {
+                // Rows were added or dropped, render once after a resync burst
+                entityListMenu.render_timer = setTimeout(function() {
+                    entityListMenu.render_timer = null;
                     renderMenu();
-                }
-            }
-
-            // Handle changed entities (updates)
-            if (ev.c) {
-                for (let entity_id in ev.c) {
-                    let patch = ev.c[entity_id];
-                    let plus = patch["+"] || {};
-
-                    // Get existing state or create new one
-                    let cur = entityStates[entity_id] || { entity_id: entity_id, state: '', attributes: {} };
-
-                    // Merge the changes
-                    entityStates[entity_id] = {
-                        entity_id: entity_id,
-                        state: plus.s !== undefined ? plus.s : cur.state,
-                        attributes: plus.a !== undefined ? plus.a : cur.attributes,
-                        context: plus.c !== undefined ? plus.c : cur.context,
-                        last_changed: plus.lc !== undefined ? new Date(plus.lc * 1000).toISOString() : cur.last_changed
-                    };
-                    ha_state_dict[entity_id] = entityStates[entity_id];
-
-                    log_message(`Entity update for ${entity_id}: ${entityStates[entity_id].state}`);
-                    updateEntityInMenu(entity_id);
-                }
-            }
-
-            // Handle removed entities
-            if (ev.r) {
-                for (let entity_id in ev.r) {
-                    delete entityStates[entity_id];
-                    delete ha_state_dict[entity_id];
-                    log_message(`Entity removed: ${entity_id}`);
-                    // Re-render menu if an entity was removed
-                    if (initialSnapshotReceived) {
-                        renderMenu();
-                    }
-                }
+                }, 100);
             }
-        }, function(error) {
-            log_message(`subscribeEntities ERROR: ` + JSON.stringify(error));
-            entityListMenu.section(0).title = 'HAWS - failed updating';
         });
     }
 
@@ -7706,46 +7499,33 @@ function showEntityList(title, entity_id_list = false, ignoreEntityCache = true,
 }
 
 // gets HA device states
+// The entity store is kept current by its subscribe_entities stream, which resyncs it from a
+// full snapshot on every (re)connect. ignoreCache waits for that snapshot instead of returning
+// the cached startup data.
 function getStates(successCallback, errorCallback, ignoreCache = false) {
-    if(!ignoreCache){
-        // check if last fetch is old and needs update
-        if(
-            ha_state_cache
-            && ha_state_cache_updated
-        ) {
-            let secondsAgo = (((new Date()).getTime() - ha_state_cache_updated.getTime()) / 1000);
-            if(secondsAgo <= ha_refresh_interval) {
-                log_message(`HA states loaded from cache (age ${secondsAgo} <= interval ${ha_refresh_interval})`);
-                if(typeof successCallback == 'function') {
-                    successCallback(ha_state_cache);
-                }
-                return;
-            }
+    if(!ignoreCache && ha_state_cache_updated) {
+        log_message('HA states loaded from entity store');
+        if(typeof successCallback == 'function') {
+            successCallback(entityStateStore.all());
         }
+        return;
     }
 
-    haws.getStates(
-        function(data) {
-            ha_state_cache = data.result;
-            let new_state_map = {};
-            for(let entity of ha_state_cache) {
-                new_state_map[entity.entity_id] = entity;
-            }
-            ha_state_dict = new_state_map;
-
+    entityStateStore.whenSynced(
+        function(states) {
             ha_state_cache_updated = new Date();
 
             // Update favorite entity friendly names from current state data
-            favoriteEntityStore.updateFriendlyNames(ha_state_dict);
+            favoriteEntityStore.updateFriendlyNames(entityStateStore.states);
 
             if(typeof successCallback == "function") {
-                successCallback(data.result);
+                successCallback(states);
             }
         },
-        function(error, status, request) {
-            log_message('HA States failed: ' + error + ' status: ' + status);
-            if(typeof successCallback == "function") {
-                errorCallback(error, status, request);
+        function(error) {
+            log_message('HA States failed: ' + JSON.stringify(error));
+            if(typeof errorCallback == "function") {
+                errorCallback(error);
             }
         }
     );
@@ -7760,33 +7540,8 @@ function getEntitiesForArea(area_id) {
         return false;
     }
 
-    if(!area_id) {
-        return getEntitiesWithoutArea();
-    }
-
-    const areaDevices = new Set();
-    // Find all devices linked to this area
-    for (const device_id in device_registry_cache) {
-        if (device_registry_cache[device_id].area_id === area_id) {
-            areaDevices.add(device_id);
-        }
-    }
-
-    const results = {};
-    // Find all entities directly linked to this area
-    // or linked to a device linked to this area.
-    for (const entity_id in entity_registry_cache) {
-        let entity = entity_registry_cache[entity_id];
-        if (
-            entity.area_id
-                ? entity.area_id === (area_id ? area_id : null)
-                : areaDevices.has(entity.device_id)
-        ) {
-            results[entity_id] = entity;
-        }
-    }
-
-    return results;
+    // Entities linked to this area directly or through their device
+    return getRegistryIndex().entitiesForArea(area_id);
 }
 
 /**
@@ -7798,25 +7553,7 @@ function getEntitiesWithoutArea() {
         return false;
     }
 
-    const noAreaDevices = new Set();
-    // Find all devices linked to this area
-    for (const device_id in device_registry_cache) {
-        if (!device_registry_cache[device_id].area_id) {
-            noAreaDevices.add(device_id);
-        }
-    }
-
-    const results = {};
-    // Find all entities directly linked to this area
-    // or linked to a device linked to this area.
-    for (const entity_id in entity_registry_cache) {
-        let entity = entity_registry_cache[entity_id];
-        if(!entity.area_id || noAreaDevices.has(entity.device_id)) {
-            results[entity_id] = entity;
-        }
-    }
-
-    return results;
+    return getRegistryIndex().entitiesWithoutArea();
 }
 
 /**
@@ -7829,15 +7566,188 @@ function getAreasForFloor(floor_id) {
         return {};
     }
 
-    const results = {};
-    for (const area_id in area_registry_cache) {
-        const area = area_registry_cache[area_id];
-        // Match areas with the specified floor_id (null matches unassigned areas)
-        if (area.floor_id === floor_id) {
-            results[area_id] = area;
+    return getRegistryIndex().areasForFloor(floor_id);
+}
+
+/**
+ * Registry lookups, rebuilt in one pass the first time they are needed after a registry
+ * cache was replaced
+ * @returns {RegistryIndex}
+ */
+function getRegistryIndex() {
+    if (!registryIndex.built) {
+        registryIndex.build(area_registry_cache, device_registry_cache, entity_registry_cache);
+    }
+    return registryIndex;
+}
+
+/**
+ * Apply registry changes from the *_registry_updated events to the registry caches and the
+ * registry index, and queue the registry for the startup cache
+ * @param {string} registry - 'areas', 'floors', 'devices', 'entities' or 'labels'
+ * @param {object} changes - id -> registry entry, null for removed entries
+ * @param {boolean} reordered - changes holds the whole registry in its new order
+ */
+function applyRegistryChanges(registry, changes, reordered) {
+    // The built index shares the area, device and entity caches and updates them itself
+    let update = function(cache, method, id, entry) {
+        if (registryIndex.built) {
+            registryIndex[method](id, entry);
+        } else if (entry) {
+            cache[id] = entry;
+        } else {
+            delete cache[id];
         }
+    };
+
+    switch (registry) {
+        case 'areas':
+            if (!area_registry_cache) return;
+            if (reordered) {
+                area_registry_cache = changes;
+                registryIndex.invalidate();
+                break;
+            }
+            for (let area_id in changes) {
+                update(area_registry_cache, 'updateArea', area_id, changes[area_id]);
+            }
+            break;
+        case 'floors':
+            if (!floor_registry_cache) return;
+            if (reordered) {
+                floor_registry_cache = {};
+            }
+            for (let floor_id in changes) {
+                let floor = changes[floor_id];
+                if (floor) {
+                    floor_registry_cache[floor_id] = { name: floor.name, level: floor.level };
+                } else {
+                    delete floor_registry_cache[floor_id];
+                }
+            }
+            break;
+        case 'devices':
+            if (!device_registry_cache) return;
+            for (let device_id in changes) {
+                update(device_registry_cache, 'updateDevice', device_id, changes[device_id]);
+            }
+            break;
+        case 'entities':
+            if (!entity_registry_cache) return;
+            for (let entity_id in changes) {
+                update(entity_registry_cache, 'updateEntity', entity_id, changes[entity_id]);
+            }
+            break;
+        case 'labels':
+            if (!label_registry_cache) return;
+            for (let label_id in changes) {
+                if (changes[label_id]) {
+                    label_registry_cache[label_id] = changes[label_id];
+                } else {
+                    delete label_registry_cache[label_id];
+                }
+            }
+            break;
+    }
+
+    log_message('Applied ' + Object.keys(changes).length + ' ' + registry + ' registry changes' +
+        (reordered ? ' (reordered)' : ''));
+    if (startup_cache_enabled) {
+        startupCacheWriter.markSection(registry);
+    }
+}
+
+/**
+ * What the first screen after auth_ok renders from: the quick launch target when the app was
+ * quick launched, or may have been while the launch reason is not known yet, and the main menu
+ * unless the quick launch exits on back
+ * @returns {{target: string, tasks: string[], entity_ids: string[]}} startup tasks to fetch first
+ *     and the entity states to prefetch for 'launch_states'
+ */
+function getStartupNeeds() {
+    const launchReason = simply.impl.state.launchReason;
+    const target = launchReason === 'quickLaunch' || !launchReason
+        ? quick_launch_behavior || 'main_menu'
+        : 'main_menu';
+    let tasks = [];
+    let entity_ids = [];
+
+    if (target === 'main_menu' || !quick_launch_exit_on_back) {
+        // Only the pinned entities need states, the other items are static
+        entity_ids = entity_ids.concat(pinnedEntityStore.all());
+    }
+    switch (target) {
+        case 'assistant':
+            tasks.push('pipelines');
+            break;
+        case 'favorites':
+            entity_ids = entity_ids.concat(favoriteEntityStore.all());
+            break;
+        case 'favorite_entity':
+            if (quick_launch_favorite_entity) {
+                entity_ids.push(quick_launch_favorite_entity);
+            }
+            break;
+        case 'areas':
+            tasks.push('areas', 'floors', 'devices', 'entities');
+            break;
+        case 'labels':
+            tasks.push('labels', 'entities');
+            break;
+        case 'todo_lists':
+        case 'people':
+            // Domain lists need every state
+            tasks.push('states');
+            break;
+    }
+    if (entity_ids.length) {
+        tasks.unshift('launch_states');
+    }
+    return { target: target, tasks: tasks, entity_ids: entity_ids };
+}
+
+/**
+ * Run a view once the startup tasks it reads from are done. Without cached data the main menu
+ * is up before the rest streams in, the loading card covers the wait.
+ * @param {string[]} tasks - startup task names, e.g. ['labels', 'entities']
+ * @param {function} show
+ */
+function whenStartupDone(tasks, show) {
+    const startup = uncachedStartup;
+    const pending = startup ? tasks.filter(name => !startup.isDone(name)) : [];
+    if (!pending.length) {
+        show();
+        return;
+    }
+
+    log_message("Waiting for " + pending.join(', ') + " before showing the view");
+    loadingCard.subtitle("Fetching data");
+    loadingCard.show();
+    let failed = null;
+    let remaining = pending.length;
+    for (let name of pending) {
+        startup.whenDone(name, function(error) {
+            if (error !== undefined && !failed) {
+                failed = name;
+            }
+            if (--remaining > 0) {
+                return;
+            }
+            // Backed out of the loading card, or a reconnect started over
+            const loadingCardVisible = WindowStack._items.some(function(w) {
+                return w._id() === loadingCard._id();
+            });
+            if (!loadingCardVisible || uncachedStartup !== startup) {
+                return;
+            }
+            if (failed) {
+                loadingCard.subtitle("Fetching " + failed + " failed");
+                return;
+            }
+            loadingCard.hide();
+            show();
+        });
     }
-    return results;
 }
 
 /**
@@ -7850,15 +7760,26 @@ function on_auth_ok(evt) {
     const fetch_start_time = Date.now();
     log_message("Starting data fetch timing...");
 
+    const startup = startupScheduler || new StartupScheduler({ log: log_message });
+    startupScheduler = null;
+    startup.mark('auth_ok');
+
     // Set connection status to true
     ha_connected = true;
     Settings.option('ha_connected', ha_connected);
 
     // Try to load from cache first
     const cacheLoaded = loadStartupCache();
+    uncachedStartup = cacheLoaded ? null : startup;
+    const needs = getStartupNeeds();
+    startup.trace.launch = needs.target;
+    startup.trace.cache = cacheLoaded;
 
-    // Track if we're fetching in background (when cache is loaded)
-    const isFetchingInBackground = cacheLoaded;
+    // Registries that were kept current up to a short disconnect serve the first screen while
+    // they are listed again, changes made while disconnected raised no events. The registry
+    // events are subscribed before the lists are requested so no change falls between.
+    const resumeRegistries = registryUpdates.canResume();
+    registryUpdates.attach(haws);
 
     // Helper function to handle the quick launch behavior with retry logic
     function handleQuickLaunch(retryCount) {
@@ -7930,9 +7851,7 @@ function on_auth_ok(evt) {
                     showToDoLists();
                     break;
                 case 'people':
-                    const personEntities = Object.keys(ha_state_dict).filter(function(entity_id) {
-                        return entity_id.startsWith('person.');
-                    });
+                    const personEntities = entityStateStore.idsForDomain('person');
                     showEntityList("People", personEntities, true, true, true);
                     break;
                 case 'main_menu':
@@ -7945,6 +7864,9 @@ function on_auth_ok(evt) {
 
     // Helper function to handle showing UI after auth (handles saved_windows, is_restarting, and quick launch)
     function showUIAfterAuth() {
+        startup.mark('first_render');
+        logTimeToFirstMenu(Date.now() - fetch_start_time, cacheLoaded);
+
         // try to resume previous WindowStack state if it's saved
         if(saved_windows) {
             WindowStack._items = [...saved_windows];
@@ -7971,27 +7893,219 @@ function on_auth_ok(evt) {
         showUIAfterAuth();
     } else {
         // No cache, show loading dialog
-        loadingCard.subtitle("Fetching states");
-        log_message("No cache available, fetching states, config areas, config devices, config entities, assist pipelines, and config labels...");
+        loadingCard.subtitle("Fetching data");
+        log_message("No cache available, fetching " + needs.tasks.join(', ') +
+            " for the first screen before the rest");
     }
 
-    // Track what has been loaded (for background fetching or initial loading)
-    let pipelines_loaded = false;
-    let states_loaded = false;
-    let areas_loaded = false;
-    let floors_loaded = false;
-    let devices_loaded = false;
-    let entities_loaded = false;
-    let labels_loaded = false;
-
     // Track if any background fetch failed
     let background_fetch_failed = false;
     let background_fetch_error = null;
 
-    let done_fetching = function(){
-        // Check that all the things have finished fetching
-        if(states_loaded && areas_loaded && floors_loaded && devices_loaded &&
-           entities_loaded && labels_loaded && pipelines_loaded) {
+    // A few entity states the first screen shows, ahead of the snapshot of every entity
+    startup.add('launch_states', needs.tasks.indexOf('launch_states') !== -1, function(done, fail) {
+        if (!needs.entity_ids.length || ha_state_cache_updated) {
+            done();
+            return;
+        }
+        entityStateStore.prefetch(haws, needs.entity_ids, done, function(error) {
+            // The full snapshot still brings them, only the first screen waits longer
+            log_message("Prefetching launch entities failed: " + JSON.stringify(error));
+            done();
+        });
+    });
+
+    // One subscribe_entities stream keeps the entity store live for every view, subscriptions do
+    // not survive a reconnect so it is reopened on each auth_ok
+    startup.add('states', needs.tasks.indexOf('states') !== -1, function(done, fail) {
+        entityStateStore.attach(haws);
+        getStates(function(){
+            log_message("States loaded.");
+            done();
+        }, function(error){
+            log_message("Fetching states failed: " + error);
+            fail("states");
+        }, true);
+    });
+
+    // Resumed registries are listed behind the first screen instead of ahead of it
+    const registryNeeded = name => !resumeRegistries && needs.tasks.indexOf(name) !== -1;
+    if (resumeRegistries) {
+        log_message("Registries are current up to the disconnect, listing them in the background");
+    }
+
+    startup.add('areas', registryNeeded('areas'), function(done, fail) {
+        haws.getConfigAreas(function(data) {
+            // log_message('config/area_registry/list response: ' + JSON.stringify(data));
+
+            area_registry_cache = {};
+            registryIndex.invalidate();
+            for(let result of data.result) {
+                // Store full area object to access floor_id for grouping
+                // {
+                //     "area_id":"9f55b85d123043cb8dfc01088302d2c7",
+                //     "floor_id": null or "main_floor",
+                //     "name":"",
+                //     "picture":null
+                // }
+                area_registry_cache[result.area_id] = result;
+            }
+            log_message("Config areas loaded.");
+            done();
+        }, function(error){
+            log_message("Fetching areas failed: " + error);
+            fail("areas");
+        });
+    });
+
+    // Fetch floors (HA 2024.4+) - gracefully handle older versions
+    startup.add('floors', registryNeeded('floors'), function(done, fail) {
+        haws.getConfigFloors(function(data) {
+            // log_message('config/floor_registry/list response: ' + JSON.stringify(data));
+
+            floor_registry_cache = {};
+            for(let result of data.result) {
+                // Store floor data - order is preserved from API (HA 2025.12+ supports manual ordering)
+                // {
+                //     "floor_id": "main_floor",
+                //     "name": "Main Floor",
+                //     "level": 1
+                // }
+                floor_registry_cache[result.floor_id] = {
+                    name: result.name,
+                    level: result.level
+                };
+            }
+            log_message("Config floors loaded (" + Object.keys(floor_registry_cache).length + " floors).");
+            done();
+        }, function(error) {
+            // Floors API not available (HA < 2024.4) or failed - continue without floors
+            log_message("Floors not available or failed: " + error);
+            floor_registry_cache = {};  // Empty = no floors, will use flat area list
+            done();
+        });
+    });
+
+    startup.add('devices', registryNeeded('devices'), function(done, fail) {
+        haws.getConfigDevices(function(data) {
+            // log_message('config/device_registry/list response: ' + JSON.stringify(data));
+            device_registry_cache = {};
+            registryIndex.invalidate();
+            for(let result of data.result) {
+                // {
+                //     "area_id":"afb218164821434386244a956d47f2eb",
+                //     "configuration_url":null,
+                //     "config_entries":[
+                //     "d1d5c0dd075844ca9146790b8647adeb"
+                // ],
+                //     "connections":[
+                //     [
+                //         "mac",
+                //         "00:17:88:01:00:de:6a:52"
+                //     ]
+                // ],
+                //     "disabled_by":null,
+                //     "entry_type":null,
+                //     "id":"d05562381cd94559a3f99f6983746bb7",
+                //     "identifiers":[
+                //     [
+                //         "hue",
+                //         "ce4a484b-76d9-4e82-989a-08874ecb7d00"
+                //     ]
+                // ],
+                //     "manufacturer":"Signify Netherlands B.V.",
+                //     "model":"Hue white lamp (LWB004)",
+                //     "name_by_user":null,
+                //     "name":"Garage Back Door Light",
+                //     "sw_version":"130.1.30000",
+                //     "hw_version":null,
+                //     "via_device_id":"a02e79078d1c4b2e87252bf3c7d560f9"
+                // }
+                device_registry_cache[result.id] = result;
+            }
+            log_message("Config devices loaded.");
+            done();
+        }, function(error){
+            log_message("Fetching devices failed: " + error);
+            fail("devices");
+        });
+    });
+
+    startup.add('entities', registryNeeded('entities'), function(done, fail) {
+        haws.getConfigEntities( function(data) {
+            // log_message('config/entity_registry/list response: ' + JSON.stringify(data));
+            entity_registry_cache = {};
+            registryIndex.invalidate();
+            for(let result of data.result) {
+                // {
+                //     "area_id":null,
+                //     "config_entry_id":"d1d5c0dd075844ca9146790b8647adeb",
+                //     "device_id":"858419a35f354fbba83cb2350cad7835",
+                //     "disabled_by":null,
+                //     "entity_category":null,
+                //     "entity_id":"light.garage_door_light_right",
+                //     "hidden_by":null,
+                //     "icon":null,
+                //     "name":null,
+                //     "platform":"hue"
+                // }
+                entity_registry_cache[result.entity_id] = result;
+            }
+
+            log_message("Config entities loaded.");
+            done();
+        }, function(error){
+            log_message("Fetching entities failed: " + error);
+            fail("entities");
+        });
+    });
+
+    startup.add('labels', registryNeeded('labels'), function(done, fail) {
+        haws.getConfigLabels(function(data) {
+            label_registry_cache = {};
+            for(let result of data.result) {
+                label_registry_cache[result.label_id] = result;
+            }
+            log_message("Config labels loaded.");
+            done();
+        }, function(error){
+            log_message("Fetching labels failed: " + error);
+            fail("labels");
+        });
+    });
+
+    startup.add('pipelines', needs.tasks.indexOf('pipelines') !== -1, function(done, fail) {
+        loadAssistPipelines(function(success){
+            if (success) {
+                done();
+            } else {
+                fail("pipelines");
+            }
+        });
+    });
+
+    startup.start({
+        onReady: function() {
+            // With the cache the first screen is already up
+            if (!cacheLoaded) {
+                log_message("Data for the first screen loaded, showing it while the rest streams in");
+                showUIAfterAuth();
+            }
+        },
+        onFailed: function(name, error, needed) {
+            if (!cacheLoaded && needed) {
+                // The first screen cannot render without it
+                loadingCard.subtitle("Fetching " + name + " failed");
+                return;
+            }
+            background_fetch_failed = true;
+            background_fetch_error = "Failed to fetch " + name;
+        },
+        onComplete: function() {
+            // A failed fetch for the first screen already left its error on the loading card
+            if (!startup.ready) {
+                return;
+            }
 
             // Calculate and log elapsed time
             const fetch_end_time = Date.now();
@@ -7999,11 +8113,15 @@ function on_auth_ok(evt) {
             log_message("Finished fetching data in " + elapsed_ms + "ms (" + (elapsed_ms/1000).toFixed(2) + "s)");
             log_message("Coalesce messages: " + (coalesce_messages_enabled ? "ENABLED" : "DISABLED"));
 
+            if (!background_fetch_failed) {
+                registryUpdates.markSynced();
+            }
+
             // Save the cache for next startup
-            saveStartupCache();
+            saveStartupCache(STARTUP_CACHE_SECTIONS);
 
-            // If we were fetching in background and there was an error, show it
-            if (isFetchingInBackground && background_fetch_failed) {
+            // If a fetch failed behind the first screen, show it
+            if (background_fetch_failed) {
                 log_message("Background fetch failed: " + background_fetch_error);
                 // Check if loading card is currently visible
                 const loadingCardVisible = WindowStack._items.some(function(w) {
@@ -8019,202 +8137,9 @@ function on_auth_ok(evt) {
                 return;
             }
 
-            // If we weren't fetching in background, show the main menu now
-            if (!isFetchingInBackground) {
-                log_message("Showing main menu");
-                showUIAfterAuth();
-            } else {
-                log_message("Background fetch completed successfully");
-            }
-        }
-    };
-
-    // Fetch states
-    getStates(function(){
-        log_message("States loaded.");
-        states_loaded = true;
-        done_fetching();
-    }, function(error){
-        log_message("Fetching states failed: " + error);
-        if (isFetchingInBackground) {
-            background_fetch_failed = true;
-            background_fetch_error = "Failed to fetch states";
-            states_loaded = true; // Mark as loaded to allow done_fetching to proceed
-            done_fetching();
-        } else {
-            loadingCard.subtitle("Fetching states failed");
-        }
-    }, true);
-
-    haws.getConfigAreas(function(data) {
-        // log_message('config/area_registry/list response: ' + JSON.stringify(data));
-
-        area_registry_cache = {};
-        for(let result of data.result) {
-            // Store full area object to access floor_id for grouping
-            // {
-            //     "area_id":"9f55b85d123043cb8dfc01088302d2c7",
-            //     "floor_id": null or "main_floor",
-            //     "name":"",
-            //     "picture":null
-            // }
-            area_registry_cache[result.area_id] = result;
-        }
-        log_message("Config areas loaded.");
-        areas_loaded = true;
-        done_fetching();
-    }, function(error){
-        log_message("Fetching areas failed: " + error);
-        if (isFetchingInBackground) {
-            background_fetch_failed = true;
-            background_fetch_error = "Failed to fetch areas";
-            areas_loaded = true; // Mark as loaded to allow done_fetching to proceed
-            done_fetching();
-        } else {
-            loadingCard.subtitle("Fetching areas failed");
+            log_message("Background fetch completed successfully");
         }
     });
-
-    // Fetch floors (HA 2024.4+) - gracefully handle older versions
-    haws.getConfigFloors(function(data) {
-        // log_message('config/floor_registry/list response: ' + JSON.stringify(data));
-
-        floor_registry_cache = {};
-        for(let result of data.result) {
-            // Store floor data - order is preserved from API (HA 2025.12+ supports manual ordering)
-            // {
-            //     "floor_id": "main_floor",
-            //     "name": "Main Floor",
-            //     "level": 1
-            // }
-            floor_registry_cache[result.floor_id] = {
-                name: result.name,
-                level: result.level
-            };
-        }
-        log_message("Config floors loaded (" + Object.keys(floor_registry_cache).length + " floors).");
-        floors_loaded = true;
-        done_fetching();
-    }, function(error) {
-        // Floors API not available (HA < 2024.4) or failed - continue without floors
-        log_message("Floors not available or failed: " + error);
-        floor_registry_cache = {};  // Empty = no floors, will use flat area list
-        floors_loaded = true;
-        done_fetching();
-    });
-
-    haws.getConfigDevices(function(data) {
-        // log_message('config/device_registry/list response: ' + JSON.stringify(data));
-        device_registry_cache = {};
-        for(let result of data.result) {
-            // {
-            //     "area_id":"afb218164821434386244a956d47f2eb",
-            //     "configuration_url":null,
-            //     "config_entries":[
-            //     "d1d5c0dd075844ca9146790b8647adeb"
-            // ],
-            //     "connections":[
-            //     [
-            //         "mac",
-            //         "00:17:88:01:00:de:6a:52"
-            //     ]
-            // ],
-            //     "disabled_by":null,
-            //     "entry_type":null,
-            //     "id":"d05562381cd94559a3f99f6983746bb7",
-            //     "identifiers":[
-            //     [
-            //         "hue",
-            //         "ce4a484b-76d9-4e82-989a-08874ecb7d00"
-            //     ]
-            // ],
-            //     "manufacturer":"Signify Netherlands B.V.",
-            //     "model":"Hue white lamp (LWB004)",
-            //     "name_by_user":null,
-            //     "name":"Garage Back Door Light",
-            //     "sw_version":"130.1.30000",
-            //     "hw_version":null,
-            //     "via_device_id":"a02e79078d1c4b2e87252bf3c7d560f9"
-            // }
-            device_registry_cache[result.id] = result;
-        }
-        log_message("Config devices loaded.");
-        devices_loaded = true;
-        done_fetching();
-    }, function(error){
-        log_message("Fetching devices failed: " + error);
-        if (isFetchingInBackground) {
-            background_fetch_failed = true;
-            background_fetch_error = "Failed to fetch devices";
-            devices_loaded = true; // Mark as loaded to allow done_fetching to proceed
-            done_fetching();
-        } else {
-            loadingCard.subtitle("Fetching devices failed");
-        }
-    });
-
-    haws.getConfigEntities( function(data) {
-        // log_message('config/entity_registry/list response: ' + JSON.stringify(data));
-        entity_registry_cache = {};
-        for(let result of data.result) {
-            // {
-            //     "area_id":null,
-            //     "config_entry_id":"d1d5c0dd075844ca9146790b8647adeb",
-            //     "device_id":"858419a35f354fbba83cb2350cad7835",
-            //     "disabled_by":null,
-            //     "entity_category":null,
-            //     "entity_id":"light.garage_door_light_right",
-            //     "hidden_by":null,
-            //     "icon":null,
-            //     "name":null,
-            //     "platform":"hue"
-            // }
-            entity_registry_cache[result.entity_id] = result;
-        }
-
-        log_message("Config entities loaded.");
-        entities_loaded = true;
-        done_fetching();
-    }, function(error){
-        log_message("Fetching entities failed: " + error);
-        if (isFetchingInBackground) {
-            background_fetch_failed = true;
-            background_fetch_error = "Failed to fetch entities";
-            entities_loaded = true; // Mark as loaded to allow done_fetching to proceed
-            done_fetching();
-        } else {
-            loadingCard.subtitle("Fetching entities failed");
-        }
-    });
-
-    haws.getConfigLabels(function(data) {
-        label_registry_cache = {};
-        for(let result of data.result) {
-            label_registry_cache[result.label_id] = result;
-        }
-        log_message("Config labels loaded.");
-        labels_loaded = true;
-        done_fetching();
-    }, function(error){
-        log_message("Fetching labels failed: " + error);
-        if (isFetchingInBackground) {
-            background_fetch_failed = true;
-            background_fetch_error = "Failed to fetch labels";
-            labels_loaded = true; // Mark as loaded to allow done_fetching to proceed
-            done_fetching();
-        } else {
-            loadingCard.subtitle("Fetching labels failed");
-        }
-    });
-
-    loadAssistPipelines(function(success){
-        pipelines_loaded = true;
-        if (!success && isFetchingInBackground) {
-            background_fetch_failed = true;
-            background_fetch_error = "Failed to fetch pipelines";
-        }
-        done_fetching();
-    });
 }
 
 function main() {
@@ -8237,20 +8162,29 @@ function main() {
 
     loadingCard.subtitle('Connecting');
     log_message('Connecting');
+    startupScheduler = new StartupScheduler({ log: log_message });
     log_message('Coalesce messages: ' + (coalesce_messages_enabled ? 'ENABLED' : 'DISABLED'));
     haws = new HAWS(ha_url, ha_password, debugHAWS, coalesce_messages_enabled);
 
     haws.on('open', function(evt){
+        if (startupScheduler) {
+            startupScheduler.mark('ws_open');
+        }
         loadingCard.subtitle('Authenticating');
     });
 
     haws.on('close', function(evt){
+        registryUpdates.detach();
+
         // If we're restarting, don't try to save/restore windows - restartApp handles that
         if (is_restarting) {
             log_message('Connection closed during restart - skipping window save');
             return;
         }
 
+        // Trace the reconnect from the moment the connection dropped
+        startupScheduler = new StartupScheduler({ log: log_message, reconnect: true });
+
         loadingCard.subtitle('Reconnecting...');
         loadingCard.show();
 
@@ -8312,19 +8246,6 @@ function main() {
     //     });
 }
 
-/*
-Expiremental reload
-*/
-if (ha_refresh_interval < 1 || typeof ha_refresh_interval == "undefined") {
-    ha_refresh_interval = 15;
-}
-let timerID = setInterval(function() {
-    if(haws.isConnected()) {
-        log_message('Reloading Home Assistant states');
-        getStates();
-    }
-}, 60000 * ha_refresh_interval);
-
 
 /**
  * Helper function to determine if we should show domain menu based on settings
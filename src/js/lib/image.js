@@ -2,24 +2,9 @@ var PNG = require('vendor/png');
 
 var PNGEncoder = require('lib/png-encoder');
 
-var image = {};
-
-var getPos = function(width, x, y) {
-  return y * width * 4 + x * 4;
-};
+var ImageCache = require('lib/imagecache');
 
-//! Convert an RGB pixel array into a single grey color
-var getPixelGrey = function(pixels, pos) {
-  return ((pixels[pos] + pixels[pos + 1] + pixels[pos + 2]) / 3) & 0xFF;
-};
-
-//! Convert an RGB pixel array into a single uint8 2 bitdepth per channel color
-var getPixelColorUint8 = function(pixels, pos) {
-  var r = Math.min(Math.max(parseInt(pixels[pos    ] / 64 + 0.5), 0), 3);
-  var g = Math.min(Math.max(parseInt(pixels[pos + 1] / 64 + 0.5), 0), 3);
-  var b = Math.min(Math.max(parseInt(pixels[pos + 2] / 64 + 0.5), 0), 3);
-  return (0x3 << 6) | (r << 4) | (g << 2) | b;
-};
+var image = {};
 
 //! Get an RGB vector from an RGB pixel array
 var getPixelColorRGB8 = function(pixels, pos) {
@@ -28,15 +13,11 @@ var getPixelColorRGB8 = function(pixels, pos) {
 
 //! Normalize the color channels to be identical
 image.greyscale = function(pixels, width, height, converter) {
-  converter = converter || getPixelGrey;
-  for (var y = 0, yy = height; y < yy; ++y) {
-    for (var x = 0, xx = width; x < xx; ++x) {
-      var pos = getPos(width, x, y);
-      var newColor = converter(pixels, pos);
-      for (var i = 0; i < 3; ++i) {
-        pixels[pos + i] = newColor;
-      }
-    }
+  var end = width * height * 4;
+  for (var pos = 0; pos < end; pos += 4) {
+    var newColor = converter ? converter(pixels, pos) :
+        ((pixels[pos] + pixels[pos + 1] + pixels[pos + 2]) / 3) & 0xFF;
+    pixels[pos] = pixels[pos + 1] = pixels[pos + 2] = newColor;
   }
 };
 
@@ -44,10 +25,9 @@ image.greyscale = function(pixels, width, height, converter) {
 image.toRaster = function(pixels, width, height, converter) {
   converter = converter || getPixelColorRGB8;
   var matrix = [];
-  for (var y = 0, yy = height; y < yy; ++y) {
+  for (var y = 0, pos = 0; y < height; ++y) {
     var row = matrix[y] = [];
-    for (var x = 0, xx = width; x < xx; ++x) {
-      var pos = getPos(width, x, y);
+    for (var x = 0; x < width; ++x, pos += 4) {
       row[x] = converter(pixels, pos);
     }
   }
@@ -100,27 +80,55 @@ var getChannel2 = function(color) {
   return Math.min(Math.max(parseInt(color / 64 + 0.5), 0) * 64, 255);
 };
 
+/**
+ * Error diffusion in a single pass over the image. All three channels of a pixel are quantized
+ * together through a lookup table of the converter, and the error is carried in a ring of
+ * Int16Array rows, one per kernel row, so the pixel buffer itself never holds out of range values.
+ */
 image.dither = function(pixels, width, height, dithers, converter) {
   converter = converter || getChannel2;
   dithers = dithers || image.dithers['default'];
   var numDithers = dithers.length;
-  for (var y = 0, yy = height; y < yy; ++y) {
-    for (var x = 0, xx = width; x < xx; ++x) {
-      var pos = getPos(width, x, y);
+
+  var levels = new Uint8Array(256);
+  for (var c = 0; c < 256; ++c) {
+    levels[c] = converter(c);
+  }
+
+  var numRows = 1;
+  var pad = 0;
+  for (var j = 0; j < numDithers; ++j) {
+    numRows = Math.max(numRows, dithers[j][1] + 1);
+    pad = Math.max(pad, Math.abs(dithers[j][0]));
+  }
+  var stride = (width + 2 * pad) * 3;
+  var errors = new Int16Array(numRows * stride);
+  var taps = new Int32Array(numDithers);
+  var weights = new Float64Array(numDithers);
+  for (j = 0; j < numDithers; ++j) {
+    weights[j] = dithers[j][2];
+  }
+
+  for (var y = 0, pos = 0; y < height; ++y) {
+    var row = (y % numRows) * stride + pad * 3;
+    for (j = 0; j < numDithers; ++j) {
+      taps[j] = ((y + dithers[j][1]) % numRows) * stride + (pad + dithers[j][0]) * 3;
+    }
+    for (var x = 0, e = row; x < width; ++x, pos += 4, e += 3) {
       for (var i = 0; i < 3; ++i) {
-        var oldColor = pixels[pos + i];
-        var newColor = converter(oldColor);
+        var oldColor = pixels[pos + i] + errors[e + i];
+        var newColor = levels[oldColor < 0 ? 0 : oldColor > 255 ? 255 : oldColor];
         var error = oldColor - newColor;
         pixels[pos + i] = newColor;
-        for (var j = 0; j < numDithers; ++j) {
-          var dither = dithers[j];
-          var x2 = x + dither[0], y2 = y + dither[1];
-          if (x2 >= 0 && x2 < width && y < height) {
-            pixels[getPos(width, x2, y2) + i] += parseInt(error * dither[2]);
+        if (error !== 0) {
+          var offset = x * 3 + i;
+          for (j = 0; j < numDithers; ++j) {
+            errors[taps[j] + offset] += (error * weights[j]) | 0;
           }
         }
       }
     }
+    errors.fill(0, row - pad * 3, row - pad * 3 + stride);
   }
 };
 
@@ -132,38 +140,49 @@ image.ditherByProps = function(pixels, img, converter) {
   }
 };
 
-image.resizeNearest = function(pixels, width, height, newWidth, newHeight) {
-  var newPixels = new Array(newWidth * newHeight * 4);
+//! Byte offsets of the source columns sampled for each destination column
+var getColumnOffsets = function(width, newWidth, shift) {
+  var offsets = new Int32Array(newWidth);
   var widthRatio = width / newWidth;
+  for (var x = 0; x < newWidth; ++x) {
+    offsets[x] = Math.min(((x * widthRatio) | 0) + shift, width - 1) * 4;
+  }
+  return offsets;
+};
+
+image.resizeNearest = function(pixels, width, height, newWidth, newHeight) {
+  var newPixels = new Uint8ClampedArray(newWidth * newHeight * 4);
+  var columns = getColumnOffsets(width, newWidth, 0);
   var heightRatio = height / newHeight;
-  for (var y = 0, yy = newHeight; y < yy; ++y) {
-    for (var x = 0, xx = newWidth; x < xx; ++x) {
-      var x2 = parseInt(x * widthRatio);
-      var y2 = parseInt(y * heightRatio);
-      var pos2 = getPos(width, x2, y2);
-      var pos = getPos(newWidth, x, y);
-      for (var i = 0; i < 4; ++i) {
-        newPixels[pos + i] = pixels[pos2 + i];
-      }
+  for (var y = 0, pos = 0; y < newHeight; ++y) {
+    var row = Math.min((y * heightRatio) | 0, height - 1) * width * 4;
+    for (var x = 0; x < newWidth; ++x, pos += 4) {
+      var pos2 = row + columns[x];
+      newPixels[pos    ] = pixels[pos2    ];
+      newPixels[pos + 1] = pixels[pos2 + 1];
+      newPixels[pos + 2] = pixels[pos2 + 2];
+      newPixels[pos + 3] = pixels[pos2 + 3];
     }
   }
   return newPixels;
 };
 
+//! Downscale averaging each sampled pixel with its right, lower and lower right neighbours
 image.resizeSample = function(pixels, width, height, newWidth, newHeight) {
-  var newPixels = new Array(newWidth * newHeight * 4);
-  var widthRatio = width / newWidth;
+  var newPixels = new Uint8ClampedArray(newWidth * newHeight * 4);
+  var left = getColumnOffsets(width, newWidth, 0);
+  var right = getColumnOffsets(width, newWidth, 1);
   var heightRatio = height / newHeight;
-  for (var y = 0, yy = newHeight; y < yy; ++y) {
-    for (var x = 0, xx = newWidth; x < xx; ++x) {
-      var x2 = Math.min(parseInt(x * widthRatio), width - 1);
-      var y2 = Math.min(parseInt(y * heightRatio), height - 1);
-      var pos = getPos(newWidth, x, y);
+  var rowBytes = width * 4;
+  for (var y = 0, pos = 0; y < newHeight; ++y) {
+    var y2 = Math.min((y * heightRatio) | 0, height - 1);
+    var top = y2 * rowBytes;
+    var bottom = Math.min(y2 + 1, height - 1) * rowBytes;
+    for (var x = 0; x < newWidth; ++x, pos += 4) {
+      var a = top + left[x], b = top + right[x];
+      var c = bottom + left[x], d = bottom + right[x];
       for (var i = 0; i < 4; ++i) {
-        newPixels[pos + i] = ((pixels[getPos(width, x2  , y2  ) + i] +
-                               pixels[getPos(width, x2+1, y2  ) + i] +
-                               pixels[getPos(width, x2  , y2+1) + i] +
-                               pixels[getPos(width, x2+1, y2+1) + i]) / 4) & 0xFF;
+        newPixels[pos + i] = (pixels[a + i] + pixels[b + i] + pixels[c + i] + pixels[d + i]) >> 2;
       }
     }
   }
@@ -187,27 +206,33 @@ image.resizeByProps = function(pixels, img) {
   }
 };
 
+//! Encodings of ImagePacket pixels, mirrors ImageFormat in simply_res.h
+image.ImageFormat = {
+  png: 0,
+  raw: 1,
+  rawRle: 2,
+};
+
+//! Mirrors GBitmapFormat of the Pebble SDK
+image.BitmapFormat = {
+  '1Bit': 0,
+  '8Bit': 1,
+  '1BitPalette': 2,
+  '2BitPalette': 3,
+  '4BitPalette': 4,
+};
+
 //! Convert to a GBitmap with bitdepth 1
 image.toGbitmap1 = function(pixels, width, height) {
-  var rowBytes = width * 4;
-
-  var gpixels = [];
   var growBytes = Math.ceil(width / 32) * 4;
-  for (var i = 0, ii = height * growBytes; i < ii; ++i) {
-    gpixels[i] = 0;
-  }
-
-  for (var y = 0, yy = height; y < yy; ++y) {
-    for (var x = 0, xx = width; x < xx; ++x) {
-      var grey = 0;
-      var pos = getPos(width, x, y);
-      for (var j = 0; j < 3; ++j) {
-        grey += pixels[pos + j];
-      }
-      grey /= 3 * 255;
-      if (grey >= 0.5) {
-        var gbytePos = y * growBytes + parseInt(x / 8);
-        gpixels[gbytePos] += 1 << (x % 8);
+  var gpixels = new Uint8Array(height * growBytes);
+
+  for (var y = 0, pos = 0; y < height; ++y) {
+    var growPos = y * growBytes;
+    for (var x = 0; x < width; ++x, pos += 4) {
+      // At least half intensity, (r + g + b) / (3 * 255) >= 0.5
+      if (pixels[pos] + pixels[pos + 1] + pixels[pos + 2] >= 383) {
+        gpixels[growPos + (x >> 3)] |= 1 << (x & 7);
       }
     }
   }
@@ -215,6 +240,8 @@ image.toGbitmap1 = function(pixels, width, height) {
   var gbitmap = {
     width: width,
     height: height,
+    format: image.ImageFormat.raw,
+    bitmapFormat: image.BitmapFormat['1Bit'],
     pixelsLength: gpixels.length,
     pixels: gpixels,
   };
@@ -222,38 +249,189 @@ image.toGbitmap1 = function(pixels, width, height) {
   return gbitmap;
 };
 
-//! Convert to a PNG with total color bitdepth 8
-image.toPng8 = function(pixels, width, height) {
-  var raster = image.toRaster(pixels, width, height, getPixelColorRGB8);
+//! Raw bitmaps need no inflate on the watch and are preferred unless this much larger than the PNG
+image.RAW_SIZE_SLACK = 1.125;
+
+//! Nearest 2 bitdepth level of a channel, same as getChannel2 without the scaling
+var getLevel2 = function(color) {
+  var level = (color + 32) >> 6;
+  return level > 3 ? 3 : level;
+};
+
+//! Map pixels to at most 64 palette entries of 2 bitdepth per channel colors
+var quantize = function(pixels, width, height) {
+  var numPixels = width * height;
+  var indices = new Uint8Array(numPixels);
 
   var palette = [];
-  var colorMap = {};
+  var colorMap = new Int8Array(64).fill(-1);
   var numColors = 0;
-  for (var y = 0, yy = height; y < yy; ++y) {
-    var row = raster[y];
-    for (var x = 0, xx = width; x < xx; ++x) {
-      var color = row[x];
-      var hash = getPixelColorUint8(color, 0);
-      if (!(hash in colorMap)) {
-        colorMap[hash] = numColors;
-        palette[numColors++] = color;
-      }
-     row[x] = colorMap[hash];
+  for (var i = 0, pos = 0; i < numPixels; ++i, pos += 4) {
+    var r = pixels[pos], g = pixels[pos + 1], b = pixels[pos + 2];
+    var hash = (getLevel2(r) << 4) | (getLevel2(g) << 2) | getLevel2(b);
+    var index = colorMap[hash];
+    if (index < 0) {
+      index = colorMap[hash] = numColors++;
+      palette[index] = [r, g, b];
     }
+    indices[i] = index;
   }
 
+  return { indices: indices, palette: palette };
+};
+
+var encodePng8 = function(quantized, width, height) {
   var bitdepth = 8;
   var colorType = 3; // 8-bit palette
-  var bytes = PNGEncoder.encode(raster, bitdepth, colorType, palette);
+  var bytes = PNGEncoder.encodeBytes(quantized.indices, width, height, bitdepth, colorType,
+                                     quantized.palette);
 
-  var png = {
+  return {
     width: width,
     height: height,
-    pixelsLength: bytes.array.length,
-    pixels: bytes.array,
+    format: image.ImageFormat.png,
+    pixelsLength: bytes.length,
+    pixels: bytes,
   };
+};
 
-  return png;
+//! Convert to a PNG with total color bitdepth 8
+image.toPng8 = function(pixels, width, height) {
+  return encodePng8(quantize(pixels, width, height), width, height);
+};
+
+/**
+ * PackBits style run length encoding. A control byte below 128 is followed by that many plus one
+ * literal bytes, any other repeats the following byte control - 126 times.
+ */
+image.packRle = function(bytes) {
+  var length = bytes.length;
+  var out = new Uint8Array(length + Math.ceil(length / 128) + 1);
+  var n = 0;
+  var i = 0;
+  while (i < length) {
+    var run = 1;
+    while (i + run < length && run < 129 && bytes[i + run] === bytes[i]) {
+      ++run;
+    }
+    if (run > 1) {
+      out[n++] = run + 126;
+      out[n++] = bytes[i];
+      i += run;
+      continue;
+    }
+    var start = i;
+    while (i < length && i - start < 128 && !(i + 1 < length && bytes[i] === bytes[i + 1])) {
+      ++i;
+    }
+    out[n++] = i - start - 1;
+    out.set(bytes.subarray(start, i), n);
+    n += i - start;
+  }
+  return out.subarray(0, n);
+};
+
+//! Pack quantized pixels as rows of the smallest fitting GBitmapFormat preceded by its palette
+var encodeRaw8 = function(quantized, width, height) {
+  var palette = quantized.palette;
+  var numColors = palette.length;
+  var bitmapFormat = numColors <= 4 ? '2BitPalette' : numColors <= 16 ? '4BitPalette' : '8Bit';
+  var paletteSize = { '2BitPalette': 4, '4BitPalette': 16, '8Bit': 0 }[bitmapFormat];
+  var bits = { '2BitPalette': 2, '4BitPalette': 4, '8Bit': 8 }[bitmapFormat];
+
+  // Pebble truncates channels to 2 bits, see GColorFromRGB
+  var colors = new Uint8Array(numColors);
+  for (var c = 0; c < numColors; ++c) {
+    var rgb = palette[c];
+    colors[c] = 0xC0 | ((rgb[0] >> 6) << 4) | ((rgb[1] >> 6) << 2) | (rgb[2] >> 6);
+  }
+
+  var rowSize = Math.ceil(width * bits / 8);
+  var bytes = new Uint8Array(paletteSize + rowSize * height);
+  var indices = quantized.indices;
+  if (paletteSize) {
+    bytes.set(colors);
+    var perByte = 8 / bits;
+    for (var y = 0, i = 0; y < height; ++y) {
+      var rowPos = paletteSize + y * rowSize;
+      for (var x = 0; x < width; ++x, ++i) {
+        // Palette indices are packed most significant bits first
+        bytes[rowPos + ((x / perByte) | 0)] |= indices[i] << ((perByte - 1 - x % perByte) * bits);
+      }
+    }
+  } else {
+    for (var j = 0, jj = width * height; j < jj; ++j) {
+      bytes[j] = colors[indices[j]];
+    }
+  }
+
+  var raw = {
+    width: width,
+    height: height,
+    format: image.ImageFormat.raw,
+    bitmapFormat: image.BitmapFormat[bitmapFormat],
+    pixelsLength: bytes.length,
+    pixels: bytes,
+  };
+
+  var packed = image.packRle(bytes.subarray(paletteSize));
+  if (paletteSize + packed.length < bytes.length) {
+    var rle = new Uint8Array(paletteSize + packed.length);
+    rle.set(bytes.subarray(0, paletteSize));
+    rle.set(packed, paletteSize);
+    raw.format = image.ImageFormat.rawRle;
+    raw.pixelsLength = rle.length;
+    raw.pixels = rle;
+  }
+  return raw;
+};
+
+/**
+ * Convert to a watch bitmap with total color bitdepth 8, either a PNG or raw rows the watch can
+ * copy without decoding, whichever is smaller allowing RAW_SIZE_SLACK in favor of raw rows.
+ */
+image.toBitmap8 = function(pixels, width, height) {
+  var quantized = quantize(pixels, width, height);
+  var raw = encodeRaw8(quantized, width, height);
+  var png = encodePng8(quantized, width, height);
+  return raw.pixelsLength <= png.pixelsLength * image.RAW_SIZE_SLACK ? raw : png;
+};
+
+//! Downscale factor of the preview tile of progressive images
+image.PREVIEW_SCALE = 4;
+
+//! Pixels per refinement tile, small enough for a tile PNG to fit a single app message
+image.TILE_PIXELS = 1024;
+
+/**
+ * Splits an image for progressive delivery: a preview at 1/PREVIEW_SCALE resolution covering the
+ * whole image, followed by full resolution strips of rows. Expects the resized pixels before
+ * dithering, the strips are taken from `dithered`.
+ */
+image.toTiles = function(pixels, dithered, img) {
+  var width = img.width, height = img.height;
+  var scale = image.PREVIEW_SCALE;
+  var previewWidth = Math.ceil(width / scale);
+  var previewHeight = Math.ceil(height / scale);
+  var preview = image.resize(pixels, width, height, previewWidth, previewHeight);
+  if (img.dither) {
+    image.dither(preview, previewWidth, previewHeight, image.dithers[img.dither]);
+  }
+  var tiles = [{
+    x: 0,
+    y: 0,
+    scale: scale,
+    image: image.toPng8(preview, previewWidth, previewHeight),
+  }];
+
+  var rows = Math.max(1, Math.floor(image.TILE_PIXELS / width));
+  var rowBytes = width * 4;
+  for (var y = 0; y < height; y += rows) {
+    var stripHeight = Math.min(rows, height - y);
+    var strip = dithered.subarray(y * rowBytes, (y + stripHeight) * rowBytes);
+    tiles.push({ x: 0, y: y, scale: 1, image: image.toPng8(strip, width, stripHeight) });
+  }
+  return tiles;
 };
 
 //! Set the size maintaining the aspect ratio
@@ -274,7 +452,23 @@ image.setSizeAspect = function(img, width, height) {
   }
 };
 
-image.load = function(img, bitdepth, callback) {
+/**
+ * Fetches, converts and encodes an image for the watch. Results are kept in ImageCache, pass
+ * `reload` to bypass it when the image behind the url may have changed. Freshly converted
+ * `progressive` images also get `tiles` for SimplyPebble.imageTiles, cached ones are sent whole.
+ */
+image.load = function(img, bitdepth, callback, reload) {
+  var cacheKey = ImageCache.key(img, bitdepth);
+  var cached = !reload && ImageCache.get(cacheKey);
+  if (cached) {
+    img.width = cached.width;
+    img.height = cached.height;
+    img.image = cached;
+    if (callback) {
+      callback(img);
+    }
+    return img;
+  }
   PNG.load(img.url, function(png) {
     var pixels = png.decode();
     if (bitdepth === 1) {
@@ -282,13 +476,22 @@ image.load = function(img, bitdepth, callback) {
     }
     image.setSizeAspect(img, png.width, png.height);
     pixels = image.resizeByProps(pixels, img);
+    // Progressive tiles are PNGs, which only color watches receive
+    var progressive = img.progressive && bitdepth === 8;
+    var undithered = progressive && img.dither ? new Uint8ClampedArray(pixels) : pixels;
     image.ditherByProps(pixels, img,
                         bitdepth === 1 ? getChannelGrey : getChannel2);
     if (bitdepth === 8) {
-      img.image = image.toPng8(pixels, img.width, img.height);
+      img.image = image.toBitmap8(pixels, img.width, img.height);
+      if (progressive) {
+        img.tiles = image.toTiles(undithered, pixels, img);
+      }
     } else if (bitdepth === 1) {
       img.image = image.toGbitmap1(pixels, img.width, img.height);
     }
+    if (img.image) {
+      ImageCache.set(cacheKey, img.image);
+    }
     if (callback) {
       callback(img);
     }
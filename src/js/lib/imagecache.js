@@ -0,0 +1,191 @@
+/**
+ * ImageCache persists watch-ready image bytes in localStorage across sessions.
+ *
+ * Entries are addressed by a hash of everything that determines the output of the image
+ * pipeline: url, requested width, height and dither, and the target bitdepth. An index of entry
+ * sizes and last use times is kept under its own key, and the least recently used entries are
+ * evicted once the cache grows over `ImageCache.maxSize` characters or localStorage is full.
+ */
+
+var ImageCache = {};
+
+ImageCache.maxSize = 512 * 1024;
+
+var INDEX_KEY = 'imagecache:index';
+var ENTRY_PREFIX = 'imagecache:';
+
+var BASE64 = 'ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/';
+var BASE64_CODES = {};
+for (var c = 0; c < BASE64.length; ++c) {
+  BASE64_CODES[BASE64.charAt(c)] = c;
+}
+
+var index;
+
+var loadIndex = function() {
+  if (index) {
+    return index;
+  }
+  try {
+    index = JSON.parse(localStorage.getItem(INDEX_KEY)) || {};
+  } catch (e) {
+    index = {};
+  }
+  return index;
+};
+
+var saveIndex = function() {
+  try {
+    localStorage.setItem(INDEX_KEY, JSON.stringify(index));
+  } catch (e) {
+    console.log('[ImageCache] Failed to save index: ' + e);
+  }
+};
+
+//! 32-bit FNV-1a of the string, as 8 hex digits
+var hashString = function(str) {
+  var hash = 0x811c9dc5;
+  for (var i = 0, ii = str.length; i < ii; ++i) {
+    hash ^= str.charCodeAt(i);
+    hash = (hash + (hash << 1) + (hash << 4) + (hash << 7) + (hash << 8) + (hash << 24)) >>> 0;
+  }
+  return ('0000000' + hash.toString(16)).slice(-8);
+};
+
+ImageCache.key = function(img, bitdepth) {
+  return ENTRY_PREFIX + hashString([img.url, img.width || 0, img.height || 0, img.dither || '',
+                                    bitdepth].join('|'));
+};
+
+ImageCache.encodeBytes = function(bytes) {
+  var out = '';
+  for (var i = 0, ii = bytes.length; i < ii; i += 3) {
+    var b0 = bytes[i];
+    var b1 = i + 1 < ii ? bytes[i + 1] : 0;
+    var b2 = i + 2 < ii ? bytes[i + 2] : 0;
+    out += BASE64.charAt(b0 >> 2) +
+           BASE64.charAt(((b0 & 0x3) << 4) | (b1 >> 4)) +
+           (i + 1 < ii ? BASE64.charAt(((b1 & 0xf) << 2) | (b2 >> 6)) : '=') +
+           (i + 2 < ii ? BASE64.charAt(b2 & 0x3f) : '=');
+  }
+  return out;
+};
+
+ImageCache.decodeBytes = function(str) {
+  var padding = str.charAt(str.length - 1) === '=' ? (str.charAt(str.length - 2) === '=' ? 2 : 1) : 0;
+  var bytes = new Array(str.length / 4 * 3 - padding);
+  for (var i = 0, j = 0, ii = str.length; i < ii; i += 4) {
+    var n = (BASE64_CODES[str.charAt(i)] << 18) |
+            (BASE64_CODES[str.charAt(i + 1)] << 12) |
+            ((BASE64_CODES[str.charAt(i + 2)] || 0) << 6) |
+            (BASE64_CODES[str.charAt(i + 3)] || 0);
+    bytes[j++] = (n >> 16) & 0xff;
+    if (j < bytes.length) { bytes[j++] = (n >> 8) & 0xff; }
+    if (j < bytes.length) { bytes[j++] = n & 0xff; }
+  }
+  return bytes;
+};
+
+/**
+ * Returns the cached image for a key, `{ width, height, format, bitmapFormat, pixelsLength,
+ * pixels }` like the encoders in lib/image produce, or undefined.
+ */
+ImageCache.get = function(key) {
+  var entry = loadIndex()[key];
+  if (!entry) {
+    return;
+  }
+  var data = localStorage.getItem(key);
+  if (!data) {
+    delete index[key];
+    saveIndex();
+    return;
+  }
+  entry.used = Date.now();
+  saveIndex();
+  var pixels = ImageCache.decodeBytes(data);
+  return {
+    width: entry.width,
+    height: entry.height,
+    format: entry.format,
+    bitmapFormat: entry.bitmapFormat,
+    pixelsLength: pixels.length,
+    pixels: pixels,
+  };
+};
+
+ImageCache.remove = function(key) {
+  localStorage.removeItem(key);
+  delete loadIndex()[key];
+};
+
+var leastRecentlyUsed = function() {
+  var oldest;
+  for (var key in index) {
+    if (!oldest || index[key].used < index[oldest].used) {
+      oldest = key;
+    }
+  }
+  return oldest;
+};
+
+//! Evicts least recently used entries until `size` more characters fit
+var makeRoom = function(size) {
+  var total = size;
+  for (var key in index) {
+    total += index[key].size;
+  }
+  while (total > ImageCache.maxSize) {
+    var oldest = leastRecentlyUsed();
+    if (!oldest) {
+      break;
+    }
+    total -= index[oldest].size;
+    ImageCache.remove(oldest);
+  }
+};
+
+ImageCache.set = function(key, image) {
+  loadIndex();
+  var data = ImageCache.encodeBytes(image.pixels);
+  if (data.length > ImageCache.maxSize) {
+    return;
+  }
+  if (index[key]) {
+    ImageCache.remove(key);
+  }
+  makeRoom(data.length);
+  for (;;) {
+    try {
+      localStorage.setItem(key, data);
+      break;
+    } catch (e) {
+      // localStorage is full, give up once there is nothing left to evict
+      var oldest = leastRecentlyUsed();
+      if (!oldest) {
+        saveIndex();
+        return;
+      }
+      ImageCache.remove(oldest);
+    }
+  }
+  index[key] = {
+    size: data.length,
+    used: Date.now(),
+    width: image.width,
+    height: image.height,
+    format: image.format,
+    bitmapFormat: image.bitmapFormat,
+  };
+  saveIndex();
+};
+
+ImageCache.clear = function() {
+  for (var key in loadIndex()) {
+    localStorage.removeItem(key);
+  }
+  index = {};
+  saveIndex();
+};
+
+module.exports = ImageCache;
@@ -10,6 +10,35 @@ var Zlib = require('vendor/zlib');
 
 var png = {};
 
+// CRC calculations are a literal translation of the C code at
+// http://www.libpng.org/pub/png/spec/1.0/PNG-CRCAppendix.html
+png.crc_table = (function() {
+  var table = new Uint32Array(256); // Table of CRCs of all 8-bit messages.
+  for (var n = 0; n < 256; n++) {
+    var c = n;
+    for (var k = 0; k < 8; k++) {
+      if (c & 1) {
+        c = 0xedb88320 ^ (c >>> 1); // C ">>" is JS ">>>"
+      } else {
+        c = c >>> 1; // C ">>" is JS ">>>"
+      }
+    }
+    table[n] = c;
+  }
+  return table;
+})();
+
+png.crc32 = function(buffer, start, end) {
+  // The CRC is initialized to all 1's, and the transmitted value
+  // is the 1's complement of the final running CRC.
+  var table = png.crc_table;
+  var c = 0xffffffff;
+  for (var n = start; n < end; n++) {
+    c = table[(c ^ buffer[n]) & 0xff] ^ (c >>> 8); // C ">>" is JS ">>>"
+  }
+  return (c ^ 0xffffffff) >>> 0; // >>>0 converts to unsigned, without changing the bits.
+};
+
 png.Bytes = function(data, optional) {
   var datum, i;
   this.array = [];
@@ -176,38 +205,8 @@ png.Chunk = function(type, data) {
     throw new Error("Creating PNG "+type+" chunk: provided data is not Bytes: "+data);
   }
 
-    // CRC calculations are a literal translation of the C code at
-  // http://www.libpng.org/pub/png/spec/1.0/PNG-CRCAppendix.html
-  if (!png.crc_table) {
-    png.crc_table = []; // Table of CRCs of all 8-bit messages.
-    for (var n = 0; n < 256; n++) {
-      var c = n;
-      for (var k = 0; k < 8; k++) {
-        if (c & 1) {
-          c = 0xedb88320 ^ (c >>> 1); // C ">>" is JS ">>>"
-        } else {
-          c = c >>> 1; // C ">>" is JS ">>>"
-        }
-      }
-      png.crc_table[n] = c;
-    }
-  }
-
-  function update_crc(crc, buffer) {
-    // Update a running CRC with the buffer--the CRC
-    // should be initialized to all 1's, and the transmitted value
-    // is the 1's complement of the final running CRC
-    var c = crc;
-    var n;
-    for (n = 0; n < buffer.length; n++) {
-      c = png.crc_table[(c ^ buffer[n]) & 0xff] ^ (c >>> 8); // C ">>" is JS ">>>"
-    }
-    return c;
-  }
-
   var type_and_data = new png.Bytes(type).add(data);
-  var crc = (update_crc(0xffffffff, type_and_data.array) ^ 0xffffffff)>>>0;
-  // >>>0 converts to unsigned, without changing the bits.
+  var crc = png.crc32(type_and_data.array, 0, type_and_data.array.length);
 
   var length_type_data_checksum =
     new png.Bytes(data.array.length,{bytes:4})
@@ -374,6 +373,115 @@ png.Chunk.IEND = function() {
   return new png.Chunk("IEND", new png.Bytes([]));
 };
 
+png.CHANNELS = { 0: 1, 2: 3, 3: 1, 6: 4 };
+
+png.scanlines = function(samples, width, height, bit_depth, color_type) {
+  // Given a typed array of one byte per sample, row major, returns the image data of an IDAT
+  // chunk. Samples narrower than a byte are packed, every row gets filter type 0.
+  var channels = png.CHANNELS[color_type];
+  var rowSamples = width * channels;
+  var rowBytes = Math.ceil(rowSamples * bit_depth / 8);
+  var buffer = new Uint8Array((rowBytes + 1) * height);
+  var src = 0;
+  var dst = 0;
+  for (var row = 0; row < height; row++) {
+    buffer[dst++] = 0;
+    if (bit_depth === 8) {
+      buffer.set(samples.subarray(src, src + rowSamples), dst);
+      dst += rowBytes;
+    } else {
+      var perByte = 8 / bit_depth;
+      for (var col = 0; col < rowSamples; col += perByte) {
+        var byte = 0;
+        for (var sub = 0; sub < perByte; sub++) {
+          byte <<= bit_depth;
+          if (col + sub < rowSamples) {
+            byte |= samples[src + col + sub];
+          }
+        }
+        buffer[dst++] = byte;
+      }
+    }
+    src += rowSamples;
+  }
+  return buffer;
+};
+
+png.encodeBytes = function(samples, width, height, bit_depth, color_type, optional_palette, optional_transparency) {
+  // Typed array counterpart of encode(): takes one byte per sample instead of a matrix,
+  // and returns the PNG as a Uint8Array written in a single pass.
+  var zipped = new Zlib.Deflate(png.scanlines(samples, width, height, bit_depth, color_type)).compress();
+  var palette = (optional_palette instanceof Array) ? optional_palette : null;
+  var trns = (optional_transparency instanceof Array) ? optional_transparency : null;
+
+  var size = 8 + (12 + 13) + (12 + zipped.length) + 12;
+  if (palette) { size += 12 + palette.length * 3; }
+  if (trns) { size += 12 + trns.length; }
+
+  var out = new Uint8Array(size);
+  var offset = 0;
+  var start;
+
+  var write32 = function(value) {
+    out[offset++] = (value >>> 24) & 0xFF;
+    out[offset++] = (value >>> 16) & 0xFF;
+    out[offset++] = (value >>> 8) & 0xFF;
+    out[offset++] = value & 0xFF;
+  };
+
+  var beginChunk = function(type, length) {
+    write32(length);
+    start = offset;
+    for (var i = 0; i < 4; i++) {
+      out[offset++] = type.charCodeAt(i);
+    }
+  };
+
+  var endChunk = function() {
+    write32(png.crc32(out, start, offset));
+  };
+
+  out.set([137, 80 /* P */, 78 /* N */, 71 /* G */, 13, 10, 26, 10], 0);
+  offset = 8;
+
+  beginChunk('IHDR', 13);
+  write32(width);
+  write32(height);
+  out[offset++] = bit_depth;
+  out[offset++] = color_type;
+  offset += 3; // compression, filter and interlace method 0
+  endChunk();
+
+  // order matters.
+  if (palette) {
+    beginChunk('PLTE', palette.length * 3);
+    for (var i = 0; i < palette.length; i++) {
+      var triple = palette[i];
+      out[offset++] = triple[0];
+      out[offset++] = triple[1];
+      out[offset++] = triple[2];
+    }
+    endChunk();
+  }
+
+  if (trns) {
+    beginChunk('tRNS', trns.length);
+    out.set(trns, offset);
+    offset += trns.length;
+    endChunk();
+  }
+
+  beginChunk('IDAT', zipped.length);
+  out.set(zipped, offset);
+  offset += zipped.length;
+  endChunk();
+
+  beginChunk('IEND', 0);
+  endChunk();
+
+  return out;
+};
+
 if (typeof module !== 'undefined') {
   module.exports = png;
 }
@@ -46,6 +46,54 @@ var makeDataViewAccessor = function(type, typeName) {
   };
 };
 
+/**
+ * Returns the UTF-8 byte length of a string without building the encoded string.
+ */
+struct.utf8Length = function(str) {
+  var length = 0;
+  for (var i = 0, ii = str.length; i < ii; ++i) {
+    var c = str.charCodeAt(i);
+    if (c < 0x80) {
+      length += 1;
+    } else if (c < 0x800) {
+      length += 2;
+    } else if (c >= 0xD800 && c < 0xDC00 && i + 1 < ii) {
+      length += 4;
+      ++i;
+    } else {
+      length += 3;
+    }
+  }
+  return length;
+};
+
+/**
+ * Encodes a string as UTF-8 into a byte array, returning the number of bytes written.
+ */
+struct.utf8Write = function(bytes, str) {
+  var j = 0;
+  for (var i = 0, ii = str.length; i < ii; ++i) {
+    var c = str.charCodeAt(i);
+    if (c < 0x80) {
+      bytes[j++] = c;
+    } else if (c < 0x800) {
+      bytes[j++] = 0xC0 | (c >> 6);
+      bytes[j++] = 0x80 | (c & 0x3F);
+    } else if (c >= 0xD800 && c < 0xDC00 && i + 1 < ii) {
+      c = 0x10000 + ((c - 0xD800) << 10) + (str.charCodeAt(++i) - 0xDC00);
+      bytes[j++] = 0xF0 | (c >> 18);
+      bytes[j++] = 0x80 | ((c >> 12) & 0x3F);
+      bytes[j++] = 0x80 | ((c >> 6) & 0x3F);
+      bytes[j++] = 0x80 | (c & 0x3F);
+    } else {
+      bytes[j++] = 0xE0 | (c >> 12);
+      bytes[j++] = 0x80 | ((c >> 6) & 0x3F);
+      bytes[j++] = 0x80 | (c & 0x3F);
+    }
+  }
+  return j;
+};
+
 for (var k in struct.types) {
   var type = struct.types[k];
   makeDataViewAccessor(type, k);
@@ -81,25 +129,21 @@ struct.types.cstring.get = function(offset) {
 };
 
 struct.types.cstring.set = function(offset, value) {
-  value = unescape(encodeURIComponent(value));
-  this._grow(offset + value.length + 1);
-  var i = offset;
+  var length = struct.utf8Length(value);
+  this._grow(offset + length + 1);
   var buffer = this._view;
-  for (var j = 0, jj = value.length; j < jj && value[i] !== '\0'; ++i, ++j) {
-    buffer.setUint8(i, value.charCodeAt(j));
-  }
-  buffer.setUint8(i, 0);
-  this._advance = value.length + 1;
+  var bytes = new Uint8Array(buffer.buffer, buffer.byteOffset + offset, length + 1);
+  struct.utf8Write(bytes, value);
+  bytes[length] = 0;
+  this._advance = length + 1;
 };
 
 struct.types.data.get = function(offset) {
   var length = this._value;
   this._cursor = offset;
   var buffer = this._view;
-  var copy = new DataView(new ArrayBuffer(length));
-  for (var i = 0; i < length; ++i) {
-    copy.setUint8(i, buffer.getUint8(i + offset));
-  }
+  var start = buffer.byteOffset + offset;
+  var copy = new DataView(buffer.buffer.slice(start, start + length));
   this._advance = length;
   return copy;
 };
@@ -110,11 +154,11 @@ struct.types.data.set = function(offset, value) {
   this._grow(offset + length);
   var buffer = this._view;
   if (value instanceof ArrayBuffer) {
-    value = new DataView(value);
-  }
-  for (var i = 0; i < length; ++i) {
-    buffer.setUint8(i + offset, value instanceof DataView ? value.getUint8(i) : value[i]);
+    value = new Uint8Array(value);
+  } else if (value instanceof DataView) {
+    value = new Uint8Array(value.buffer, value.byteOffset, value.byteLength);
   }
+  new Uint8Array(buffer.buffer, buffer.byteOffset + offset, length).set(value);
   this._advance = length;
 };
 
@@ -123,11 +167,9 @@ struct.prototype._grow = function(target) {
   var size = buffer.byteLength;
   if (target <= size) { return; }
   while (size < target) { size *= 2; }
-  var copy = new DataView(new ArrayBuffer(size));
-  for (var i = 0; i < buffer.byteLength; ++i) {
-    copy.setUint8(i, buffer.getUint8(i));
-  }
-  this._view = copy;
+  var copy = new Uint8Array(size);
+  copy.set(new Uint8Array(buffer.buffer, buffer.byteOffset, buffer.byteLength));
+  this._view = new DataView(copy.buffer);
 };
 
 struct.prototype._prevField = function(field) {
@@ -11,6 +11,7 @@ var state;
 ImageService.init = function() {
   state = ImageService.state = {
     cache: {},
+    ids: {},
     nextId: Resource.items.length + 1,
     rootUrl: undefined,
   };
@@ -28,6 +29,9 @@ var makeImageHash = function(image) {
   if (image.dither) {
     hashPart += ',dither:' + image.dither;
   }
+  if (image.progressive) {
+    hashPart += ',progressive';
+  }
   if (hashPart) {
     url += '#' + hashPart.substr(1);
   }
@@ -78,6 +82,9 @@ ImageService.load = function(opt, reset, callback) {
   }
   if (!image || reset === true) {
     fetch = true;
+    if (image) {
+      delete state.ids[image.id];
+    }
     image = {
       id: state.nextId++,
       url: url,
@@ -86,11 +93,16 @@ ImageService.load = function(opt, reset, callback) {
   image.width = opt.width;
   image.height = opt.height;
   image.dither =  opt.dither;
+  image.progressive = opt.progressive;
   image.loaded = true;
   state.cache[hash] = image;
+  state.ids[image.id] = image;
   var onLoad = function() {
     // Only send image if image data is available
-    if (image.image) {
+    if (image.tiles) {
+      simply.impl.imageTiles(image.id, image);
+      delete image.tiles;
+    } else if (image.image) {
       simply.impl.image(image.id, image.image);
     } else {
       console.log('[ImageService] ERROR: Image data unavailable for: ' + image.url);
@@ -106,7 +118,7 @@ ImageService.load = function(opt, reset, callback) {
   };
   if (fetch) {
     var bitdepth = Feature.color(8, 1);
-    imagelib.load(image, bitdepth, onLoad);
+    imagelib.load(image, bitdepth, onLoad, reset === true);
   } else {
     onLoad();
   }
@@ -126,6 +138,16 @@ ImageService.resolve = function(opt) {
   return typeof id !== 'undefined' ? id : ImageService.load(opt);
 };
 
+/**
+ * Marks an image the watch reported as evicted, so the next reference sends it again.
+ */
+ImageService.markUnloaded = function(id) {
+  var image = state.ids[id];
+  if (image) {
+    delete image.loaded;
+  }
+};
+
 ImageService.markAllUnloaded = function() {
   for (var k in state.cache) {
     delete state.cache[k].loaded;
@@ -185,12 +185,58 @@ Menu.prototype._resolveItem = function(e) {
   }
 };
 
+/**
+ * Sends the defined items of a row range, batching each contiguous run into one command.
+ */
+Menu.prototype._resolveItems = function(sectionIndex, itemIndex, count) {
+  if (this !== WindowStack.top()) { return; }
+  var start = itemIndex;
+  var batch = [];
+  for (var i = itemIndex, ii = itemIndex + count; i <= ii; ++i) {
+    var item = i < ii && this._getItem({ sectionIndex: sectionIndex, itemIndex: i });
+    if (item) {
+      if (batch.length === 0) {
+        start = i;
+      }
+      batch.push(item);
+    } else if (batch.length) {
+      simply.impl.menuItems.call(this, sectionIndex, start, batch);
+      batch = [];
+    }
+  }
+};
+
 Menu.prototype._preloadItems = function(e) {
-  var select = util2.copy(e);
-  select.itemIndex = Math.max(0, select.itemIndex - Math.floor(this._numPreloadItems / 2));
-  for (var i = 0; i < this._numPreloadItems; ++i) {
-    this._resolveItem(select);
-    select.itemIndex++;
+  var start = Math.max(0, e.itemIndex - Math.floor(this._numPreloadItems / 2));
+  this._resolveItems(e.sectionIndex, start, this._numPreloadItems);
+};
+
+/**
+ * Defers resolving a requested item to the end of the current tick, so that the rows the watch
+ * requests together go out as batches.
+ */
+Menu.prototype._requestItem = function(e) {
+  var requests = this._itemRequests || (this._itemRequests = []);
+  requests.push(e);
+  if (requests.length === 1) {
+    setTimeout(this._resolveItemRequests.bind(this), 0);
+  }
+};
+
+Menu.prototype._resolveItemRequests = function() {
+  var requests = this._itemRequests;
+  this._itemRequests = [];
+  requests.sort(function(a, b) {
+    return (a.sectionIndex - b.sectionIndex) || (a.itemIndex - b.itemIndex);
+  });
+  for (var i = 0, ii = requests.length; i < ii;) {
+    var first = requests[i];
+    var last = first;
+    while (++i < ii && requests[i].sectionIndex === first.sectionIndex &&
+           requests[i].itemIndex <= last.itemIndex + 1) {
+      last = requests[i];
+    }
+    this._resolveItems(first.sectionIndex, first.itemIndex, last.itemIndex - first.itemIndex + 1);
   }
 };
 
@@ -361,7 +407,7 @@ Menu.emitItem = function(sectionIndex, itemIndex) {
   if (Menu.emit('item', null, e) === false) {
     return false;
   }
-  menu._resolveItem(e);
+  menu._requestItem(e);
 };
 
 Menu.emitSelect = function(type, sectionIndex, itemIndex) {
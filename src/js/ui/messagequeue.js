@@ -0,0 +1,118 @@
+/**
+ * MessageQueue is an app message transport that guarantees delivery and order while keeping a
+ * window of messages in flight.
+ *
+ * Every message is stamped with a 16-bit sequence number. The watch only applies the message it
+ * expects next and silently discards anything else, so a NACK (or timeout) for one message means
+ * every later message still in the window was discarded as well. Retransmission therefore
+ * restarts at the failed sequence; messages before it are never sent again.
+ *
+ * Until the first ack, messages are sent one at a time and carry a random session id, which lets
+ * the watch adopt the phone's sequence numbering after either side restarts without mistaking a
+ * resent first message for a new session.
+ */
+var MessageQueue = function(options) {
+  options = options || {};
+
+  this._windowSize = Math.max(options.windowSize || 1, 1);
+  this._sendAppMessage = options.sendAppMessage || function(message, success, failure) {
+    Pebble.sendAppMessage(message, success, failure);
+  };
+
+  this._queue = [];
+  this._inflight = [];
+  this._nextSeq = 0;
+  this._synced = false;
+  this._session = 1 + Math.floor(Math.random() * 0x7ffffffe);
+
+  this.stats = {
+    sentMessages: 0,
+    sentBytes: 0,
+    ackedMessages: 0,
+    retransmits: 0,
+    nacks: 0,
+  };
+};
+
+MessageQueue.SEQUENCE_KEY = 1;
+MessageQueue.SESSION_KEY = 2;
+MessageQueue.SEQUENCE_MASK = 0xffff;
+
+MessageQueue.prototype.send = function(message) {
+  this._queue.push(message);
+  this.pump();
+};
+
+MessageQueue.prototype.pending = function() {
+  return this._queue.length + this._inflight.length;
+};
+
+MessageQueue.prototype.pump = function() {
+  var windowSize = this._synced ? this._windowSize : 1;
+  while (this._inflight.length < windowSize && this._queue.length) {
+    var entry = {
+      seq: this._nextSeq,
+      message: this._queue.shift(),
+      acked: false,
+      attempt: 0,
+    };
+    this._nextSeq = (this._nextSeq + 1) & MessageQueue.SEQUENCE_MASK;
+    this._inflight.push(entry);
+    this.transmit(entry);
+  }
+};
+
+MessageQueue.prototype.transmit = function(entry) {
+  var payload = {};
+  for (var k in entry.message) {
+    payload[k] = entry.message[k];
+  }
+  payload[MessageQueue.SEQUENCE_KEY] = entry.seq;
+  if (!this._synced) {
+    payload[MessageQueue.SESSION_KEY] = this._session;
+  }
+
+  if (entry.attempt > 0) {
+    this.stats.retransmits++;
+  }
+  var attempt = ++entry.attempt;
+  entry.acked = false;
+
+  var data = entry.message[0];
+  this.stats.sentMessages++;
+  this.stats.sentBytes += data && data.length ? data.length : 0;
+
+  // Callbacks of a superseded attempt are ignored
+  var self = this;
+  this._sendAppMessage(payload, function() {
+    if (entry.attempt === attempt) {
+      self.onAck(entry);
+    }
+  }, function() {
+    if (entry.attempt === attempt) {
+      self.onNack(entry);
+    }
+  });
+};
+
+MessageQueue.prototype.onAck = function(entry) {
+  entry.acked = true;
+  this.stats.ackedMessages++;
+  this._synced = true;
+
+  var inflight = this._inflight;
+  while (inflight.length && inflight[0].acked) {
+    inflight.shift();
+  }
+  this.pump();
+};
+
+MessageQueue.prototype.onNack = function(entry) {
+  this.stats.nacks++;
+  var inflight = this._inflight;
+  for (var i = inflight.indexOf(entry); i >= 0 && i < inflight.length; ++i) {
+    this.transmit(inflight[i]);
+  }
+};
+
+module.exports = MessageQueue;
@@ -0,0 +1,135 @@
+/**
+ * PacketQueue is a packet queue that combines multiple packets into a single packet.
+ * This reduces latency caused by the time spacing between each app message.
+ *
+ * Packets are copied with a single `Uint8Array#set` into a buffer preallocated to the maximum
+ * payload size and reused across flushes. Only the flushed message is converted to the plain
+ * array that `Pebble.sendAppMessage` expects.
+ *
+ * Packet types listed in `keyLengths` overwrite watch state addressed by the first bytes of their
+ * body. A pending packet of such a type is dropped when a newer one with the same key is added, so
+ * only the last write is sent. The newer packet keeps its own position, behind anything queued in
+ * between. Packet types listed in `barriers` change what later packets address, and nothing is
+ * coalesced across them.
+ */
+var PacketQueue = function(options) {
+  this._maxPayloadSize = options.maxPayloadSize;
+  this._sendMessage = options.sendMessage;
+  this._keyLengths = options.keyLengths || [];
+  this._barriers = options.barriers || [];
+  this._buffer = new Uint8Array(this._maxPayloadSize);
+  this._length = 0;
+  this._pending = {};
+  this._pendingList = [];
+
+  this.stats = {
+    coalescedPackets: 0,
+    savedBytes: 0,
+  };
+
+  this._send = this.send.bind(this);
+};
+
+/**
+ * Returns a view of the bytes of a struct packet without copying them.
+ * The view aliases the packet's buffer, so it must be consumed before the packet is reused.
+ */
+PacketQueue.toBytes = function(packet, size) {
+  var view = packet._view;
+  return new Uint8Array(view.buffer, view.byteOffset, size);
+};
+
+/**
+ * Copies an app message byte array into a DataView in one pass.
+ */
+PacketQueue.toDataView = function(array) {
+  return new DataView(new Uint8Array(array).buffer);
+};
+
+var HEADER_SIZE = 4;
+
+var packetType = function(bytes) {
+  return bytes[0] | (bytes[1] << 8);
+};
+
+var packetKey = function(bytes, type, keyLength) {
+  var key = type;
+  for (var i = 0; i < keyLength; ++i) {
+    key = key * 256 + bytes[HEADER_SIZE + i];
+  }
+  return key;
+};
+
+PacketQueue.prototype.add = function(bytes) {
+  var type = packetType(bytes);
+  var keyLength = this._keyLengths[type];
+  var key;
+  if (keyLength) {
+    key = packetKey(bytes, type, keyLength);
+    var pending = this._pending[key];
+    if (pending) {
+      this._remove(pending);
+    }
+  } else if (this._barriers[type]) {
+    this._clearPending();
+  }
+
+  if (this._length + bytes.length > this._maxPayloadSize) {
+    this.send();
+  }
+  if (!this._timeout) {
+    this._timeout = setTimeout(this._send, 0);
+  }
+  if (keyLength) {
+    var entry = { key: key, offset: this._length, length: bytes.length };
+    this._pending[key] = entry;
+    this._pendingList.push(entry);
+  }
+  this._buffer.set(bytes, this._length);
+  this._length += bytes.length;
+};
+
+PacketQueue.prototype._remove = function(entry) {
+  var end = entry.offset + entry.length;
+  this._buffer.copyWithin(entry.offset, end, this._length);
+  this._length -= entry.length;
+
+  var list = this._pendingList;
+  list.splice(list.indexOf(entry), 1);
+  for (var i = 0, ii = list.length; i < ii; ++i) {
+    if (list[i].offset >= end) {
+      list[i].offset -= entry.length;
+    }
+  }
+  delete this._pending[entry.key];
+
+  this.stats.coalescedPackets++;
+  this.stats.savedBytes += entry.length;
+};
+
+PacketQueue.prototype._clearPending = function() {
+  if (this._pendingList.length) {
+    this._pending = {};
+    this._pendingList = [];
+  }
+};
+
+PacketQueue.prototype.send = function() {
+  clearTimeout(this._timeout);
+  this._timeout = null;
+  this._clearPending();
+  if (this._length === 0) {
+    return;
+  }
+  // Generic array methods are slow on typed arrays, an indexed copy is not
+  var buffer = this._buffer;
+  var length = this._length;
+  var message = new Array(length);
+  for (var i = 0; i < length; ++i) {
+    message[i] = buffer[i];
+  }
+  this._length = 0;
+  this._sendMessage(message);
+};
+
+module.exports = PacketQueue;
@@ -13,6 +13,8 @@ var WindowStack = require('ui/windowstack');
 var Window = require('ui/window');
 var Menu = require('ui/menu');
 var StageElement = require('ui/element');
+var MessageQueue = require('ui/messagequeue');
+var PacketQueue = require('ui/packetqueue');
 var Vector2 = require('vector2');
 
 var simply = require('ui/simply');
@@ -38,7 +40,7 @@ var StringType = function(x) {
 };
 
 var UTF8ByteLength = function(x) {
-  return unescape(encodeURIComponent(x)).length;
+  return struct.utf8Length(x);
 };
 
 var EnumerableType = function(x) {
@@ -382,6 +384,8 @@ var Packet = new struct([
 var SegmentPacket = new struct([
   [Packet, 'packet'],
   ['bool', 'isLast'],
+  ['uint32', 'totalLength'],
+  ['uint32', 'offset'],
   ['data', 'buffer'],
 ]);
 
@@ -487,6 +491,25 @@ var ImagePacket = new struct([
   ['uint32', 'id'],
   ['int16', 'width'],
   ['int16', 'height'],
+  ['uint8', 'format'],
+  ['uint8', 'bitmapFormat'],
+  ['uint16', 'pixelsLength'],
+  ['data', 'pixels'],
+]);
+
+var ImageEvictedPacket = new struct([
+  [Packet, 'packet'],
+  ['uint32', 'id'],
+]);
+
+var ImageTilePacket = new struct([
+  [Packet, 'packet'],
+  ['uint32', 'id'],
+  ['int16', 'width'],
+  ['int16', 'height'],
+  ['int16', 'x'],
+  ['int16', 'y'],
+  ['uint8', 'scale'],
   ['uint16', 'pixelsLength'],
   ['data', 'pixels'],
 ]);
@@ -599,6 +622,16 @@ var MenuItemPacket = new struct([
   ['cstring', 'subtitle', StringType],
 ]);
 
+var MenuItemsPacket = new struct([
+  [Packet, 'packet'],
+  ['uint16', 'section'],
+  ['uint16', 'item'],
+  ['uint16', 'count'],
+  ['data', 'buffer'],
+]);
+
+var MenuItemsEntrySize = 8;
+
 var MenuGetItemPacket = new struct([
   [Packet, 'packet'],
   ['uint16', 'section'],
@@ -732,6 +765,8 @@ var ElementAnimateDonePacket = new struct([
   ['uint32', 'id'],
 ]);
 
+// Retired single text size request, the watch only answers CalculateTextSizesPacket. The
+// packets stay listed so the command ids after them do not shift.
 var CalculateTextSizePacket = new struct([
   [Packet, 'packet'],
   ['uint8', 'font_key'],
@@ -747,6 +782,25 @@ var CalculateTextSizeResponsePacket = new struct([
   ['uint16', 'height'],
 ]);
 
+var CalculateTextSizesPacket = new struct([
+  [Packet, 'packet'],
+  ['uint8', 'count'],
+  ['data', 'buffer'],
+]);
+
+var TextSizeRequestSize = 9;
+
+var TextSizeResult = new struct([
+  ['uint16', 'requestId'],
+  ['uint16', 'width'],
+  ['uint16', 'height'],
+]);
+
+var CalculateTextSizesResponsePacket = new struct([
+  [Packet, 'packet'],
+  ['uint8', 'count'],
+]);
+
 var VoiceDictationStartPacket = new struct([
   [Packet, 'packet'],
   ['bool', 'enableConfirmation'],
@@ -762,6 +816,31 @@ var VoiceDictationDataPacket = new struct([
   ['cstring', 'transcription'],
 ]);
 
+var GetMsgStatsPacket = new struct([
+  [Packet, 'packet'],
+]);
+
+var MsgStatsPacket = new struct([
+  [Packet, 'packet'],
+  ['uint16', 'queueDepth'],
+  ['uint16', 'maxQueueDepth'],
+  ['uint32', 'sentMessages'],
+  ['uint32', 'retries'],
+  ['uint32', 'avgQueueMs'],
+  ['uint32', 'maxQueueMs'],
+  ['uint32', 'droppedPackets'],
+  ['uint32', 'unknownPackets'],
+  ['uint32', 'malformedPackets'],
+  ['uint32', 'droppedMessages'],
+  ['uint32', 'outOfOrderMessages'],
+  ['uint32', 'imageBytes'],
+  ['uint32', 'imageBudget'],
+  ['uint16', 'images'],
+  ['uint32', 'imageHits'],
+  ['uint32', 'imageMisses'],
+  ['uint32', 'imageEvictions'],
+]);
+
 var CommandPackets = [
   Packet,
   SegmentPacket,
@@ -821,8 +900,48 @@ var CommandPackets = [
   VoiceDictationDataPacket,
   CalculateTextSizePacket,
   CalculateTextSizeResponsePacket,
+  GetMsgStatsPacket,
+  MsgStatsPacket,
+  MenuItemsPacket,
+  ImageEvictedPacket,
+  ImageTilePacket,
+  CalculateTextSizesPacket,
+  CalculateTextSizesResponsePacket,
+];
+
+/**
+ * Packets that overwrite the watch state addressed by the first bytes of their body, mapped to the
+ * number of key bytes. PacketQueue only sends the last pending packet for each key.
+ */
+var CoalescedPackets = [
+  [MenuItemPacket, 4],
+  [MenuSectionPacket, 2],
+  [ElementCommonPacket, 4],
+  [ElementTextPacket, 4],
+  [CardTextPacket, 1],
+  [WindowPropsPacket, 4],
 ];
 
+/**
+ * Packets that change which window later packets address, or that read the state earlier
+ * packets set: an animation starts from the frame the element has when it arrives.
+ */
+var CoalesceBarrierPackets = [
+  WindowShowPacket,
+  WindowHidePacket,
+  ElementAnimatePacket,
+];
+
+var PacketKeyLengths = [];
+CoalescedPackets.forEach(function(entry) {
+  PacketKeyLengths[CommandPackets.indexOf(entry[0])] = entry[1];
+});
+
+var PacketBarriers = [];
+CoalesceBarrierPackets.forEach(function(packet) {
+  PacketBarriers[CommandPackets.indexOf(packet)] = true;
+});
+
 var accelAxes = [
   'x',
   'y',
@@ -843,6 +962,17 @@ var clearFlagMap = {
 
 var SimplyPebble = {};
 
+/**
+ * Number of app messages kept in flight at once.
+ * Two already keep the link busy in bench/transport.js, more only add retransmits.
+ */
+SimplyPebble.messageWindowSize = 2;
+
+/**
+ * Largest combined packet payload of a single app message.
+ */
+SimplyPebble.maxPayloadSize = (Platform.version() === 'aplite' ? 1024 : 2044) - 32;
+
 SimplyPebble.init = function() {
   // Register listeners for app message communication
   Pebble.addEventListener('appmessage', SimplyPebble.onAppMessage);
@@ -858,70 +988,32 @@ SimplyPebble.init = function() {
   // This will be updated when we receive the actual launch reason
   state.launchReason = null;
 
+  // Pending text size requests and their callbacks by request id
+  state.textSizeRequests = [];
+  state.textSizeCallbacks = {};
+  state.textSizeRequestId = 0;
+  // Request ids of the batches sent, the watch answers them in order
+  state.textSizeBatches = [];
+
   // Initialize the app message queue
-  state.messageQueue = new MessageQueue();
+  state.messageQueue = new MessageQueue({
+    windowSize: SimplyPebble.messageWindowSize,
+  });
 
   // Initialize the packet queue
-  state.packetQueue = new PacketQueue();
+  state.packetQueue = new PacketQueue({
+    maxPayloadSize: SimplyPebble.maxPayloadSize,
+    keyLengths: PacketKeyLengths,
+    barriers: PacketBarriers,
+    sendMessage: function(message) {
+      state.messageQueue.send({ 0: message });
+    },
+  });
 
   // Signal the Pebble that the Phone's app message is ready
   SimplyPebble.ready();
 };
 
-/**
- * MessageQueue is an app message queue that guarantees delivery and order.
- */
-var MessageQueue = function() {
-  this._queue = [];
-  this._sending = false;
-
-  this._consume = this.consume.bind(this);
-  this._cycle = this.cycle.bind(this);
-};
-
-MessageQueue.prototype.stop = function() {
-  this._sending = false;
-};
-
-MessageQueue.prototype.consume = function() {
-  this._queue.shift();
-  if (this._queue.length === 0) {
-    return this.stop();
-  }
-  this.cycle();
-};
-
-MessageQueue.prototype.checkSent = function(message, fn) {
-  return function() {
-    if (message === this._sent) {
-      fn();
-    }
-  }.bind(this);
-};
-
-MessageQueue.prototype.cycle = function() {
-  if (!this._sending) {
-    return;
-  }
-  var head = this._queue[0];
-  if (!head) {
-    return this.stop();
-  }
-  this._sent = head;
-  var success = this.checkSent(head, this._consume);
-  var failure = this.checkSent(head, this._cycle);
-  Pebble.sendAppMessage(head, success, failure);
-};
-
-MessageQueue.prototype.send = function(message) {
-  this._queue.push(message);
-  if (this._sending) {
-    return;
-  }
-  this._sending = true;
-  this.cycle();
-};
-
 var toByteArray = function(packet) {
   if (!packet || typeof packet._size === 'undefined') {
     console.log('[SimplyPebble] ERROR: toByteArray called with undefined or invalid packet');
@@ -932,54 +1024,27 @@ var toByteArray = function(packet) {
   packet.packetType(type);
   packet.packetLength(size);
 
-  var buffer = packet._view;
-  var byteArray = new Array(size);
-  for (var i = 0; i < size; ++i) {
-    byteArray[i] = buffer.getUint8(i);
-  }
-
-  return byteArray;
+  return PacketQueue.toBytes(packet, size);
 };
 
 /**
- * PacketQueue is a packet queue that combines multiple packets into a single packet.
- * This reduces latency caused by the time spacing between each app message.
+ * Splits a packet too large for one app message into segments.
+ * Every segment carries the total length and its offset so the watch can write it directly into
+ * a single reassembly buffer.
  */
-var PacketQueue = function() {
-  this._message = [];
-
-  this._send = this.send.bind(this);
-};
-
-PacketQueue.prototype._maxPayloadSize = (Platform.version() === 'aplite' ? 1024 : 2044) - 32;
-
-PacketQueue.prototype.add = function(packet) {
-  var byteArray = toByteArray(packet);
-  if (this._message.length + byteArray.length > this._maxPayloadSize) {
-    this.send();
-  }
-  Array.prototype.push.apply(this._message, byteArray);
-  clearTimeout(this._timeout);
-  this._timeout = setTimeout(this._send, 0);
-};
-
-PacketQueue.prototype.send = function() {
-  if (this._message.length === 0) {
-    return;
-  }
-  state.messageQueue.send({ 0: this._message });
-  this._message = [];
-};
-
 SimplyPebble.sendMultiPacket = function(packet) {
   var byteArray = toByteArray(packet);
   var totalSize = byteArray.length;
-  var segmentSize = state.packetQueue._maxPayloadSize - Packet._size;
+  var segmentSize = state.packetQueue._maxPayloadSize - SegmentPacket._size;
   for (var i = 0; i < totalSize; i += segmentSize) {
     var isLast = (i + segmentSize) >= totalSize;
-    var buffer = byteArray.slice(i, Math.min(totalSize, i + segmentSize));
-    SegmentPacket.isLast((i + segmentSize) >= totalSize).buffer(buffer);
-    state.packetQueue.add(SegmentPacket);
+    var buffer = byteArray.subarray(i, Math.min(totalSize, i + segmentSize));
+    SegmentPacket
+      .isLast(isLast)
+      .totalLength(totalSize)
+      .offset(i)
+      .buffer(buffer);
+    state.packetQueue.add(toByteArray(SegmentPacket));
   }
 };
 
@@ -988,8 +1053,8 @@ SimplyPebble.sendPacket = function(packet) {
     console.log('[SimplyPebble] WARNING: Attempted to send undefined or invalid packet');
     return;
   }
-  if (packet._cursor < state.packetQueue._maxPayloadSize) {
-    state.packetQueue.add(packet);
+  if (packet._cursor <= state.packetQueue._maxPayloadSize) {
+    state.packetQueue.add(toByteArray(packet));
   } else {
     SimplyPebble.sendMultiPacket(packet);
   }
@@ -1078,7 +1143,32 @@ SimplyPebble.image = function(id, gbitmap) {
     console.log('[SimplyPebble] WARNING: image called with undefined gbitmap for id ' + id);
     return;
   }
-  SimplyPebble.sendPacket(ImagePacket.id(id).prop(gbitmap));
+  ImagePacket
+    .id(id)
+    .format(gbitmap.format || 0)
+    .bitmapFormat(gbitmap.bitmapFormat || 0)
+    .prop(gbitmap);
+  SimplyPebble.sendPacket(ImagePacket);
+};
+
+/**
+ * Sends a progressively delivered image tile by tile. The watch patches each tile into one
+ * bitmap of the full image size and repaints, so the low resolution preview shows first.
+ */
+SimplyPebble.imageTiles = function(id, img) {
+  for (var i = 0, ii = img.tiles.length; i < ii; ++i) {
+    var tile = img.tiles[i];
+    ImageTilePacket
+      .id(id)
+      .width(img.width)
+      .height(img.height)
+      .x(tile.x)
+      .y(tile.y)
+      .scale(tile.scale)
+      .pixelsLength(tile.image.pixelsLength)
+      .pixels(tile.image.pixels);
+    SimplyPebble.sendPacket(ImageTilePacket);
+  }
 };
 
 var toClearFlags = function(clear) {
@@ -1161,6 +1251,30 @@ SimplyPebble.accelConfig = function(def) {
   SimplyPebble.sendPacket(AccelConfigPacket.prop(def));
 };
 
+var msgStatsListeners = [];
+
+/**
+ * Query the watch outbox telemetry: queue depth, retries, time spent queued and dropped packets.
+ * @param {function} callback - Function to call with the stats object
+ */
+SimplyPebble.msgStats = function(callback) {
+  msgStatsListeners.push(callback);
+  SimplyPebble.sendPacket(GetMsgStatsPacket);
+};
+
+SimplyPebble.onMsgStats = function(packet) {
+  var stats = packet.prop();
+  delete stats.packetType;
+  delete stats.packetLength;
+  stats.transport = state.messageQueue.stats;
+  stats.packets = state.packetQueue.stats;
+  var handlers = msgStatsListeners;
+  msgStatsListeners = [];
+  for (var i = 0, ii = handlers.length; i < ii; ++i) {
+    handlers[i](stats);
+  }
+};
+
 SimplyPebble.voiceDictationStart = function(callback, enableConfirmation) {
   if (Platform.version() === 'aplite') {
     // If there is no microphone, call with an error event
@@ -1245,6 +1359,69 @@ SimplyPebble.menuItem = function(section, item, def) {
   SimplyPebble.sendPacket(MenuItemPacket);
 };
 
+/**
+ * Sends a contiguous range of rows, packing as many rows into each MenuItemsPacket as fit in one
+ * app message. Each row is an icon and string lengths entry, followed by a string table with the
+ * title and subtitle of every row.
+ */
+SimplyPebble.menuItems = function(section, item, defs) {
+  var maxSize = state.packetQueue._maxPayloadSize - MenuItemsPacket._size;
+  var start = 0;
+  while (start < defs.length) {
+    var rows = [];
+    var size = 0;
+    for (var i = start; i < defs.length; ++i) {
+      var def = defs[i];
+      var title = StringType(def.title);
+      var subtitle = StringType(def.subtitle);
+      var row = {
+        icon: ImageType(def.icon),
+        title: title,
+        subtitle: subtitle,
+        titleLength: struct.utf8Length(title),
+        subtitleLength: struct.utf8Length(subtitle),
+      };
+      var rowSize = MenuItemsEntrySize + row.titleLength + row.subtitleLength + 2;
+      if (rows.length && size + rowSize > maxSize) {
+        break;
+      }
+      rows.push(row);
+      size += rowSize;
+    }
+    if (rows.length === 1) {
+      SimplyPebble.menuItem(section, item + start, defs[start]);
+    } else {
+      sendMenuItemRows(section, item + start, rows, size);
+    }
+    start += rows.length;
+  }
+};
+
+var sendMenuItemRows = function(section, item, rows, size) {
+  var bytes = new Uint8Array(size);
+  var view = new DataView(bytes.buffer);
+  var offset = 0;
+  var i, row;
+  for (i = 0; i < rows.length; ++i) {
+    row = rows[i];
+    view.setUint32(offset, row.icon, true);
+    view.setUint16(offset + 4, row.titleLength, true);
+    view.setUint16(offset + 6, row.subtitleLength, true);
+    offset += MenuItemsEntrySize;
+  }
+  for (i = 0; i < rows.length; ++i) {
+    row = rows[i];
+    offset += struct.utf8Write(bytes.subarray(offset), row.title) + 1;
+    offset += struct.utf8Write(bytes.subarray(offset), row.subtitle) + 1;
+  }
+  MenuItemsPacket
+    .section(section)
+    .item(item)
+    .count(rows.length)
+    .buffer(bytes);
+  SimplyPebble.sendPacket(MenuItemsPacket);
+};
+
 SimplyPebble.menuSelection = function(section, item, align) {
   if (section === undefined) {
     SimplyPebble.sendPacket(MenuGetSelectionPacket);
@@ -1314,10 +1491,6 @@ SimplyPebble.elementText = function(id, text, timeUnits) {
   SimplyPebble.sendPacket(ElementTextPacket.id(id).updateTimeUnits(timeUnits).text(text));
 };
 
-// Define command constants based on the C enum values
-var CommandCalculateTextSize = 61;
-var CommandCalculateTextSizeResponse = 62;
-
 // Font key mapping
 var fontKeyMap = {
   'gothic-14': 0,
@@ -1351,8 +1524,12 @@ var alignmentMap = {
   'right': 2
 };
 
+// The watch answers a whole batch in one response, keep it well under the outbox size
+var TEXT_SIZE_BATCH_MAX = 32;
+
 /**
- * Calculate text size (width and height) directly without needing an existing UI element
+ * Calculate text size (width and height) directly without needing an existing UI element.
+ * Requests made in the same turn are measured together in CalculateTextSizesPackets.
  * @param {string} text - The text to measure
  * @param {string} font - The font name
  * @param {number} width - The width constraint
@@ -1361,29 +1538,94 @@ var alignmentMap = {
  * @param {function} callback - Function to call with the size object {width, height}
  */
 SimplyPebble.calculateTextSize = function(text, font, width, overflow, alignment, callback) {
-  console.log('calculateTextSize called with text:', text.substring(0, 20) + '...');
-
-  // Store the callback for later use
-  state.calculateTextSizeCallback = callback;
-
-  // Get font key from font name
-  var fontKey = fontKeyMap[font] || 0;
-
-  // Get overflow mode
-  var overflowMode = overflowModeMap[overflow] || 0;
-
-  // Get alignment
-  var textAlignment = alignmentMap[alignment] || 0;
+  text = StringType(text);
+  var requestId = state.textSizeRequestId = (state.textSizeRequestId + 1) & 0xFFFF;
+  state.textSizeCallbacks[requestId] = callback;
+  state.textSizeRequests.push({
+    id: requestId,
+    fontKey: fontKeyMap[font] || 0,
+    width: width,
+    overflowMode: overflowModeMap[overflow] || 0,
+    alignment: alignmentMap[alignment] || 0,
+    text: text,
+    textLength: struct.utf8Length(text),
+  });
+  if (state.textSizeRequests.length === 1) {
+    setTimeout(flushTextSizeRequests, 0);
+  }
+};
 
-  // Send the packet
-  CalculateTextSizePacket
-    .font_key(fontKey)
-    .width(width)
-    .overflow_mode(overflowMode)
-    .alignment(textAlignment)
-    .text(text);
+/**
+ * Sends the queued text size requests, packing as many as fit in one app message. Each entry is
+ * the request id, font key, width, overflow mode, alignment and text length followed by the text.
+ */
+var flushTextSizeRequests = function() {
+  var requests = state.textSizeRequests;
+  state.textSizeRequests = [];
+  var maxSize = state.packetQueue._maxPayloadSize - CalculateTextSizesPacket._size;
+  var start = 0;
+  while (start < requests.length) {
+    var size = 0;
+    var end = start;
+    for (; end < requests.length && end - start < TEXT_SIZE_BATCH_MAX; ++end) {
+      var requestSize = TextSizeRequestSize + requests[end].textLength + 1;
+      if (end > start && size + requestSize > maxSize) {
+        break;
+      }
+      size += requestSize;
+    }
+    sendTextSizeRequests(requests.slice(start, end), size);
+    start = end;
+  }
+};
 
-  SimplyPebble.sendPacket(CalculateTextSizePacket);
+var sendTextSizeRequests = function(requests, size) {
+  var bytes = new Uint8Array(size);
+  var view = new DataView(bytes.buffer);
+  var offset = 0;
+  for (var i = 0; i < requests.length; ++i) {
+    var request = requests[i];
+    view.setUint16(offset, request.id, true);
+    view.setUint8(offset + 2, request.fontKey);
+    view.setUint16(offset + 3, request.width, true);
+    view.setUint8(offset + 5, request.overflowMode);
+    view.setUint8(offset + 6, request.alignment);
+    view.setUint16(offset + 7, request.textLength + 1, true);
+    offset += TextSizeRequestSize;
+    offset += struct.utf8Write(bytes.subarray(offset), request.text) + 1;
+  }
+  CalculateTextSizesPacket
+    .count(requests.length)
+    .buffer(bytes);
+  SimplyPebble.sendPacket(CalculateTextSizesPacket);
+  state.textSizeBatches.push(requests.map(function(request) { return request.id; }));
+};
+
+SimplyPebble.onTextSizes = function(packet) {
+  var count = packet.count();
+  var batch = state.textSizeBatches.shift() || [];
+  TextSizeResult._view = packet._view;
+  TextSizeResult._offset = packet._offset + packet._size;
+  for (var i = 0; i < count; ++i) {
+    var requestId = TextSizeResult.requestId();
+    var callback = state.textSizeCallbacks[requestId];
+    delete state.textSizeCallbacks[requestId];
+    if (callback) {
+      callback({
+        width: TextSizeResult.width(),
+        height: TextSizeResult.height(),
+      });
+    }
+    TextSizeResult._offset += TextSizeResult._size;
+  }
+  // Requests of the batch the watch could not read get a zero size instead of waiting forever
+  batch.forEach(function(requestId) {
+    var callback = state.textSizeCallbacks[requestId];
+    delete state.textSizeCallbacks[requestId];
+    if (callback) {
+      callback({ width: 0, height: 0 });
+    }
+  });
 };
 
 /**
@@ -1476,15 +1718,6 @@ SimplyPebble.stage = function(def, clear, pushing) {
 
 SimplyPebble.window = SimplyPebble.stage;
 
-var toArrayBuffer = function(array, length) {
-  length = length || array.length;
-  var copy = new DataView(new ArrayBuffer(length));
-  for (var i = 0; i < length; ++i) {
-    copy.setUint8(i, array[i]);
-  }
-  return copy;
-};
-
 SimplyPebble.onLaunchReason = function(packet) {
   var reason = LaunchReasonTypes[packet.reason()];
   var args = packet.args();
@@ -1565,9 +1798,15 @@ SimplyPebble.onPacket = function(buffer, offset) {
       Wakeup.emitWakeup(packet.id(), packet.cookie());
       break;
     case WindowHideEventPacket:
-      ImageService.markAllUnloaded();
       WindowStack.emitHide(packet.id());
       break;
+    case ImageEvictedPacket:
+      if (packet.id()) {
+        ImageService.markUnloaded(packet.id());
+      } else {
+        ImageService.markAllUnloaded();
+      }
+      break;
     case ClickPacket:
       Window.emitClick('click', ButtonTypes[packet.button()]);
       break;
@@ -1601,15 +1840,11 @@ SimplyPebble.onPacket = function(buffer, offset) {
     case VoiceDictationDataPacket:
       SimplyPebble.onVoiceData(packet);
       break;
-    case CalculateTextSizeResponsePacket:
-      console.log('Received direct text size calculation response: width=' + packet.width() + ', height=' + packet.height());
-      if (state.calculateTextSizeCallback) {
-        state.calculateTextSizeCallback({
-          width: packet.width(),
-          height: packet.height()
-        });
-        delete state.calculateTextSizeCallback;
-      }
+    case MsgStatsPacket:
+      SimplyPebble.onMsgStats(packet);
+      break;
+    case CalculateTextSizesResponsePacket:
+      SimplyPebble.onTextSizes(packet);
       break;
   }
 };
@@ -1617,7 +1852,7 @@ SimplyPebble.onPacket = function(buffer, offset) {
 SimplyPebble.onAppMessage = function(e) {
   var data = e.payload[0];
 
-  Packet._view = toArrayBuffer(data);
+  Packet._view = PacketQueue.toDataView(data);
 
   var offset = 0;
   var length = data.length;
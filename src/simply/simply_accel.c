@@ -60,7 +60,7 @@ static bool send_accel_data(SimplyMsg *self, AccelData *data, uint32_t num_sampl
   packet->is_peek = is_peek;
   packet->num_samples = num_samples;
   memcpy(packet->data, data, data_length);
-  bool result = simply_msg_send((uint8_t*) packet, length);
+  bool result = simply_msg_send_packet(&packet->packet);
   free(packet);
   return result;
 }
@@ -17,10 +17,6 @@
 
 #include <pebble.h>
 
-#define MAX_CACHED_SECTIONS 10
-
-#define MAX_CACHED_ITEMS IF_APLITE_ELSE(6, 51)
-
 #define EMPTY_TITLE ""
 
 #define SPINNER_MS 66
@@ -79,6 +75,26 @@ struct __attribute__((__packed__)) MenuItemPacket {
   char buffer[];
 };
 
+//! A contiguous range of rows. `entries` holds `num_items` MenuItemsEntry followed by a string
+//! table with a NUL terminated title and subtitle for every row in order.
+typedef struct MenuItemsPacket MenuItemsPacket;
+
+struct __attribute__((__packed__)) MenuItemsPacket {
+  Packet packet;
+  uint16_t section;
+  uint16_t item;
+  uint16_t num_items;
+  uint8_t entries[];
+};
+
+typedef struct MenuItemsEntry MenuItemsEntry;
+
+struct __attribute__((__packed__)) MenuItemsEntry {
+  uint32_t icon;
+  uint16_t title_length;
+  uint16_t subtitle_length;
+};
+
 typedef struct MenuItemEventPacket MenuItemEventPacket;
 
 struct __attribute__((__packed__)) MenuItemEventPacket {
@@ -157,27 +173,12 @@ static bool prv_send_menu_select_long_click(uint16_t section, uint16_t index) {
   return prv_send_menu_item(CommandMenuLongSelect, section, index);
 }
 
-static bool prv_section_filter(List1Node *node, void *data) {
-  SimplyMenuCommon *section = (SimplyMenuCommon *)node;
-  const uint16_t section_index = (uint16_t)(uintptr_t) data;
-  return (section->section == section_index);
-}
-
-static bool prv_item_filter(List1Node *node, void *data) {
-  SimplyMenuItem *item = (SimplyMenuItem *)node;
-  const uint32_t cell_index = (uint32_t)(uintptr_t) data;
-  const uint16_t section_index = cell_index;
-  const uint16_t row = cell_index >> 16;
-  return (item->section == section_index && item->item == row);
-}
-
-static bool prv_request_item_filter(List1Node *node, void *data) {
-  return (((SimplyMenuItem *)node)->title == NULL);
+static uint32_t prv_cell_key(uint16_t section, uint16_t row) {
+  return section | ((uint32_t) row << 16);
 }
 
 static SimplyMenuSection *prv_get_menu_section(SimplyMenu *self, int index) {
-  return (SimplyMenuSection*) list1_find(self->menu_layer.sections, prv_section_filter,
-                                         (void*)(uintptr_t) index);
+  return (SimplyMenuSection *)lru_find(&self->menu_layer.sections, index);
 }
 
 static void prv_free_title(char **title) {
@@ -189,54 +190,51 @@ static void prv_free_title(char **title) {
 
 static void prv_destroy_section(SimplyMenu *self, SimplyMenuSection *section) {
   if (!section) { return; }
-  list1_remove(&self->menu_layer.sections, &section->node);
+  lru_remove(&self->menu_layer.sections, &section->node);
   prv_free_title(&section->title);
   free(section);
 }
 
 static void prv_destroy_section_by_index(SimplyMenu *self, int section) {
-  SimplyMenuSection *section_node =
-      (SimplyMenuSection *)list1_find(self->menu_layer.sections, prv_section_filter,
-                                      (void *)(uintptr_t)section);
-  prv_destroy_section(self, section_node);
+  prv_destroy_section(self, prv_get_menu_section(self, section));
 }
 
 static SimplyMenuItem *prv_get_menu_item(SimplyMenu *self, int section, int index) {
-  const uint32_t cell_index = section | (index << 16);
-  return (SimplyMenuItem *) list1_find(self->menu_layer.items, prv_item_filter,
-                                      (void *)(uintptr_t) cell_index);
+  return (SimplyMenuItem *)lru_find(&self->menu_layer.items, prv_cell_key(section, index));
 }
 
 static void prv_destroy_item(SimplyMenu *self, SimplyMenuItem *item) {
   if (!item) { return; }
-  list1_remove(&self->menu_layer.items, &item->node);
+  lru_remove(&self->menu_layer.items, &item->node);
+  if (item->title == NULL) {
+    self->menu_layer.num_pending_items--;
+  }
   prv_free_title(&item->title);
   prv_free_title(&item->subtitle);
   free(item);
 }
 
 static void prv_destroy_item_by_index(SimplyMenu *self, int section, int index) {
-  const uint32_t cell_index = section | (index << 16);
-  SimplyMenuItem *item =
-      (SimplyMenuItem *)list1_find(self->menu_layer.items, prv_item_filter,
-                                   (void *)(uintptr_t) cell_index);
-  prv_destroy_item(self, item);
+  prv_destroy_item(self, prv_get_menu_item(self, section, index));
 }
 
 static void prv_add_section(SimplyMenu *self, SimplyMenuSection *section) {
-  if (list1_size(self->menu_layer.sections) >= MAX_CACHED_SECTIONS) {
-    prv_destroy_section(self, (SimplyMenuSection *)list1_last(self->menu_layer.sections));
-  }
   prv_destroy_section_by_index(self, section->section);
-  list1_prepend(&self->menu_layer.sections, &section->node);
+  if (self->menu_layer.sections.size >= MAX_CACHED_SECTIONS) {
+    prv_destroy_section(self, (SimplyMenuSection *)lru_last(&self->menu_layer.sections));
+  }
+  lru_insert(&self->menu_layer.sections, &section->node, section->section);
 }
 
 static void prv_add_item(SimplyMenu *self, SimplyMenuItem *item) {
-  if (list1_size(self->menu_layer.items) >= MAX_CACHED_ITEMS) {
-    prv_destroy_item(self, (SimplyMenuItem*) list1_last(self->menu_layer.items));
-  }
   prv_destroy_item_by_index(self, item->section, item->item);
-  list1_prepend(&self->menu_layer.items, &item->node);
+  if (self->menu_layer.items.size >= MAX_CACHED_ITEMS) {
+    prv_destroy_item(self, (SimplyMenuItem *)lru_last(&self->menu_layer.items));
+  }
+  if (item->title == NULL) {
+    self->menu_layer.num_pending_items++;
+  }
+  lru_insert(&self->menu_layer.items, &item->node, prv_cell_key(item->section, item->item));
 }
 
 static void prv_request_menu_section(SimplyMenu *self, uint16_t section_index) {
@@ -340,16 +338,25 @@ static void spinner_timer_callback(void *data) {
   refresh_spinner_timer(self);
 }
 
-static SimplyMenuItem *get_first_request_item(SimplyMenu *self) {
-  return (SimplyMenuItem *)list1_find(self->menu_layer.items, prv_request_item_filter, NULL);
+static bool has_request_item(SimplyMenu *self) {
+  return (self->menu_layer.num_pending_items > 0);
 }
 
 static SimplyMenuItem *get_last_request_item(SimplyMenu *self) {
-  return (SimplyMenuItem *)list1_find_last(self->menu_layer.items, prv_request_item_filter, NULL);
+  if (!has_request_item(self)) {
+    return NULL;
+  }
+  for (LruNode *node = lru_last(&self->menu_layer.items); node; node = node->prev) {
+    SimplyMenuItem *item = (SimplyMenuItem *)node;
+    if (item->title == NULL) {
+      return item;
+    }
+  }
+  return NULL;
 }
 
 static void refresh_spinner_timer(SimplyMenu *self) {
-  if (!self->spinner_timer && get_first_request_item(self)) {
+  if (!self->spinner_timer && has_request_item(self)) {
     self->spinner_timer = app_timer_register(SPINNER_MS, spinner_timer_callback, self);
   }
 }
@@ -625,8 +632,7 @@ static void prv_menu_draw_header_callback(GContext *ctx, const Layer *cell_layer
     return;
   }
 
-  list1_remove(&self->menu_layer.sections, &section->node);
-  list1_prepend(&self->menu_layer.sections, &section->node);
+  lru_touch(&self->menu_layer.sections, &section->node);
 
   GRect bounds = layer_get_bounds(cell_layer);
 
@@ -677,6 +683,37 @@ static void simply_menu_draw_row_spinner(SimplyMenu *self, GContext *ctx,
   }
 }
 
+#if !defined(PBL_PLATFORM_APLITE)
+//! Measures the row text on the first draw while selected. Marquee frames reuse the metrics, and
+//! an item with new text is a new item with unmeasured metrics.
+static const SimplyMenuItemMetrics *prv_get_item_metrics(SimplyMenuItem *item) {
+  SimplyMenuItemMetrics *metrics = &item->metrics;
+  if (metrics->is_measured) {
+    return metrics;
+  }
+
+  // For round displays, use the system theme fonts which are:
+  // - Title: GOTHIC_24_BOLD (Medium content size)
+  // - Subtitle: GOTHIC_18 (Medium content size)
+  const GFont title_font = fonts_get_system_font(FONT_KEY_GOTHIC_24_BOLD);
+  const GFont subtitle_font = fonts_get_system_font(FONT_KEY_GOTHIC_18);
+  metrics->title_width = graphics_text_layout_get_content_size(
+      item->title, title_font, GRect(0, 0, 1000, 100),
+      GTextOverflowModeTrailingEllipsis, GTextAlignmentCenter).w;
+  metrics->title_height = graphics_text_layout_get_content_size(
+      "A", title_font, GRect(0, 0, 100, 100), GTextOverflowModeFill, GTextAlignmentLeft).h;
+  if (item->subtitle) {
+    metrics->subtitle_width = graphics_text_layout_get_content_size(
+        item->subtitle, subtitle_font, GRect(0, 0, 1000, 100),
+        GTextOverflowModeTrailingEllipsis, GTextAlignmentCenter).w;
+    metrics->subtitle_height = graphics_text_layout_get_content_size(
+        "A", subtitle_font, GRect(0, 0, 100, 100), GTextOverflowModeFill, GTextAlignmentLeft).h;
+  }
+  metrics->is_measured = true;
+  return metrics;
+}
+#endif
+
 static void prv_menu_draw_row_callback(GContext *ctx, const Layer *cell_layer,
                                        MenuIndex *cell_index, void *data) {
   SimplyMenu *self = data;
@@ -701,8 +738,7 @@ static void prv_menu_draw_row_callback(GContext *ctx, const Layer *cell_layer,
     return;
   }
 
-  list1_remove(&self->menu_layer.items, &item->node);
-  list1_prepend(&self->menu_layer.items, &item->node);
+  lru_touch(&self->menu_layer.items, &item->node);
 
   // Disable icons on APLITE platform to save memory
   SimplyImage *image = NULL;
@@ -750,33 +786,11 @@ static void prv_menu_draw_row_callback(GContext *ctx, const Layer *cell_layer,
     available_width -= 20; // left/right margins for centered text
 #endif
 
-    // Measure title text
-    // For round displays, use the system theme fonts which are:
-    // - Title: GOTHIC_24_BOLD (Medium content size)
-    // - Subtitle: GOTHIC_18 (Medium content size)
-    const GFont title_font = fonts_get_system_font(FONT_KEY_GOTHIC_24_BOLD);
-    GSize title_size = graphics_text_layout_get_content_size(
-        item->title, title_font,
-        GRect(0, 0, 1000, 100),
-        GTextOverflowModeTrailingEllipsis,
-        GTextAlignmentCenter);
-
-    // Check if title needs scrolling
-    bool title_needs_scroll = title_size.w > available_width;
-
-    // Measure subtitle if present
-    bool subtitle_needs_scroll = false;
-    int16_t subtitle_width = 0;
-    if (item->subtitle) {
-      const GFont subtitle_font = fonts_get_system_font(FONT_KEY_GOTHIC_18);
-      GSize subtitle_size = graphics_text_layout_get_content_size(
-          item->subtitle, subtitle_font,
-          GRect(0, 0, 1000, 100),
-          GTextOverflowModeTrailingEllipsis,
-          GTextAlignmentCenter);
-      subtitle_width = subtitle_size.w;
-      subtitle_needs_scroll = subtitle_size.w > available_width;
-    }
+    const SimplyMenuItemMetrics *metrics = prv_get_item_metrics(item);
+    const int16_t title_width = metrics->title_width;
+    const int16_t subtitle_width = metrics->subtitle_width;
+    const bool title_needs_scroll = title_width > available_width;
+    const bool subtitle_needs_scroll = item->subtitle && subtitle_width > available_width;
 
     // Set needs_scrolling flag and calculate max offset
 #if defined(PBL_ROUND)
@@ -784,25 +798,11 @@ static void prv_menu_draw_row_callback(GContext *ctx, const Layer *cell_layer,
     self->title_needs_scroll = title_needs_scroll;
     self->subtitle_needs_scroll = subtitle_needs_scroll;
 
-    // Cache font heights to avoid expensive measurements during drawing
-    const GFont title_font_for_height = fonts_get_system_font(FONT_KEY_GOTHIC_24_BOLD);
-    GSize title_height_size = graphics_text_layout_get_content_size(
-        "A", title_font_for_height, GRect(0, 0, 100, 100),
-        GTextOverflowModeFill, GTextAlignmentLeft);
-    self->title_height = title_height_size.h;
-
-    if (item->subtitle) {
-      const GFont subtitle_font_for_height = fonts_get_system_font(FONT_KEY_GOTHIC_18);
-      GSize subtitle_height_size = graphics_text_layout_get_content_size(
-          "A", subtitle_font_for_height, GRect(0, 0, 100, 100),
-          GTextOverflowModeFill, GTextAlignmentLeft);
-      self->subtitle_height = subtitle_height_size.h;
-    } else {
-      self->subtitle_height = 0;
-    }
+    self->title_height = metrics->title_height;
+    self->subtitle_height = metrics->subtitle_height;
 
     if (title_needs_scroll) {
-      self->title_max_scroll_offset = title_size.w - available_width + 40;
+      self->title_max_scroll_offset = title_width - available_width + 40;
     } else {
       self->title_max_scroll_offset = 0;
     }
@@ -820,7 +820,7 @@ static void prv_menu_draw_row_callback(GContext *ctx, const Layer *cell_layer,
     if (self->needs_scrolling) {
       // Calculate how far we need to scroll to show all text
       // Add extra padding (40px) to ensure the last word is fully visible
-      int16_t max_title_scroll = title_needs_scroll ? (title_size.w - available_width + 40) : 0;
+      int16_t max_title_scroll = title_needs_scroll ? (title_width - available_width + 40) : 0;
       int16_t max_subtitle_scroll = subtitle_needs_scroll ? (subtitle_width - available_width + 40) : 0;
       self->max_scroll_offset = max_title_scroll > max_subtitle_scroll ?
           max_title_scroll : max_subtitle_scroll;
@@ -1107,7 +1107,6 @@ static void prv_menu_window_disappear(Window *window) {
   }
 
   if (simply_window_disappear(&self->window)) {
-    simply_res_clear(self->window.simply->res);
     simply_menu_clear(self);
   }
 }
@@ -1133,21 +1132,22 @@ static void prv_menu_window_unload(Window *window) {
 }
 
 static void simply_menu_clear_section_items(SimplyMenu *self, int section_index) {
-  SimplyMenuItem *item = NULL;
-  do {
-    item = (SimplyMenuItem *)list1_find(self->menu_layer.items, prv_section_filter,
-                                        (void *)(uintptr_t) section_index);
-    prv_destroy_item(self, item);
-  } while (item);
+  for (LruNode *node = self->menu_layer.items.head; node;) {
+    SimplyMenuItem *item = (SimplyMenuItem *)node;
+    node = node->next;
+    if (item->section == section_index) {
+      prv_destroy_item(self, item);
+    }
+  }
 }
 
 static void simply_menu_clear(SimplyMenu *self) {
-  while (self->menu_layer.sections) {
-    prv_destroy_section(self, (SimplyMenuSection *)self->menu_layer.sections);
+  while (self->menu_layer.sections.head) {
+    prv_destroy_section(self, (SimplyMenuSection *)self->menu_layer.sections.head);
   }
 
-  while (self->menu_layer.items) {
-    prv_destroy_item(self, (SimplyMenuItem *)self->menu_layer.items);
+  while (self->menu_layer.items.head) {
+    prv_destroy_item(self, (SimplyMenuItem *)self->menu_layer.items.head);
   }
 
   prv_reload_data(self);
@@ -1215,6 +1215,49 @@ static void prv_handle_menu_item_packet(Simply *simply, Packet *data) {
   simply_menu_add_item(simply->menu, item);
 }
 
+static void prv_handle_menu_items_packet(Simply *simply, Packet *data) {
+  MenuItemsPacket *packet = (MenuItemsPacket *)data;
+  SimplyMenu *self = simply->menu;
+  if (data->length < sizeof(*packet) ||
+      (data->length - sizeof(*packet)) / sizeof(MenuItemsEntry) < packet->num_items) {
+    return;
+  }
+  const MenuItemsEntry *entries = (const MenuItemsEntry *)packet->entries;
+  const char *strings = (const char *)&entries[packet->num_items];
+  const char *end = (const char *)data + data->length;
+  for (uint16_t i = 0; i < packet->num_items; ++i) {
+    const MenuItemsEntry *entry = &entries[i];
+    const char *title = strings;
+    if ((size_t)(end - title) < (size_t)entry->title_length + 1 ||
+        title[entry->title_length] != '\0') {
+      break;
+    }
+    const char *subtitle = title + entry->title_length + 1;
+    if ((size_t)(end - subtitle) < (size_t)entry->subtitle_length + 1 ||
+        subtitle[entry->subtitle_length] != '\0') {
+      break;
+    }
+    strings = subtitle + entry->subtitle_length + 1;
+    SimplyMenuItem *item = malloc(sizeof(*item));
+    if (!item) {
+      break;
+    }
+    *item = (SimplyMenuItem) {
+      .section = packet->section,
+      .item = packet->item + i,
+      .title = entry->title_length ? strndup2(title, entry->title_length) : EMPTY_TITLE,
+      .subtitle = entry->subtitle_length ? strndup2(subtitle, entry->subtitle_length) : NULL,
+      .icon = entry->icon,
+    };
+    // A NULL title marks a pending row, fall back like simply_menu_add_item when out of memory
+    if (!item->title) {
+      item->title = EMPTY_TITLE;
+    }
+    prv_add_item(self, item);
+  }
+  prv_mark_dirty(self);
+}
+
 static void prv_handle_menu_get_selection_packet(Simply *simply, Packet *data) {
   prv_send_menu_selection(simply->menu);
 }
@@ -1245,6 +1288,9 @@ bool simply_menu_handle_packet(Simply *simply, Packet *packet) {
     case CommandMenuItem:
       prv_handle_menu_item_packet(simply, packet);
       return true;
+    case CommandMenuItems:
+      prv_handle_menu_items_packet(simply, packet);
+      return true;
     case CommandMenuSelection:
       prv_handle_menu_selection_packet(simply, packet);
       return true;
@@ -1296,6 +1342,9 @@ SimplyMenu *simply_menu_create(Simply *simply) {
   };
   self->window.window_handlers = &s_window_handlers;
 
+  lru_init(&self->menu_layer.sections, self->menu_layer.section_buckets, MENU_SECTION_BUCKETS);
+  lru_init(&self->menu_layer.items, self->menu_layer.item_buckets, MENU_ITEM_BUCKETS);
+
   simply_window_init(&self->window, simply);
   simply_window_set_background_color(&self->window, GColor8White);
 
@@ -6,13 +6,23 @@
 
 #include "simply.h"
 
-#include "util/list1.h"
+#include "util/lru.h"
+#include "util/platform.h"
 
 #include <pebble.h>
 
 //! Default cell height in pixels
 #define MENU_CELL_BASIC_CELL_HEIGHT ((const int16_t) 44)
 
+#define MAX_CACHED_SECTIONS 10
+
+#define MAX_CACHED_ITEMS IF_APLITE_ELSE(6, 51)
+
+//! Hash buckets of the row cache, a power of two above the cache capacity
+#define MENU_SECTION_BUCKETS 16
+
+#define MENU_ITEM_BUCKETS IF_APLITE_ELSE(8, 64)
+
 typedef enum SimplyMenuType SimplyMenuType;
 
 enum SimplyMenuType {
@@ -25,8 +35,11 @@ typedef struct SimplyMenuLayer SimplyMenuLayer;
 
 struct SimplyMenuLayer {
   MenuLayer *menu_layer;
-  List1Node *sections;
-  List1Node *items;
+  LruTable sections;
+  LruTable items;
+  LruNode *section_buckets[MENU_SECTION_BUCKETS];
+  LruNode *item_buckets[MENU_ITEM_BUCKETS];
+  uint16_t num_pending_items;
   uint16_t num_sections;
   GColor8 normal_foreground;
   GColor8 normal_background;
@@ -71,7 +84,7 @@ struct SimplyMenu {
 typedef struct SimplyMenuCommon SimplyMenuCommon;
 
 struct SimplyMenuCommon {
-  List1Node node;
+  LruNode node;
   uint16_t section;
   char *title;
 };
@@ -94,6 +107,18 @@ struct SimplyMenuSection {
   GColor8 title_background;
 };
 
+typedef struct SimplyMenuItemMetrics SimplyMenuItemMetrics;
+
+//! Text sizes of a row for marquee scrolling. Items are replaced whenever their text changes, so
+//! the metrics stay valid for the lifetime of the item.
+struct SimplyMenuItemMetrics {
+  int16_t title_width;
+  int16_t subtitle_width;
+  int16_t title_height;
+  int16_t subtitle_height;
+  bool is_measured;
+};
+
 typedef struct SimplyMenuItem SimplyMenuItem;
 
 struct SimplyMenuItem {
@@ -101,6 +126,9 @@ struct SimplyMenuItem {
   char *subtitle;
   uint32_t icon;
   uint16_t item;
+#if !defined(PBL_PLATFORM_APLITE)
+  SimplyMenuItemMetrics metrics;
+#endif
 };
 
 SimplyMenu *simply_menu_create(Simply *simply);
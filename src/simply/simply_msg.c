@@ -22,6 +22,12 @@
 
 #define SEND_DELAY_MS 10
 
+#define SEND_MAX_DELAY_MS 1000
+
+//! Pending accel data packets kept before the oldest is dropped
+#define MAX_BULK_QUEUE_LENGTH 4
+
+
 static const size_t APP_MSG_SIZE_INBOUND = IF_APLITE_ELSE(1024, 2044);
 static const size_t APP_MSG_SIZE_OUTBOUND = 1024;
 
@@ -46,6 +52,8 @@ typedef struct SegmentPacket SegmentPacket;
 struct __attribute__((__packed__)) SegmentPacket {
   Packet packet;
   bool is_last;
+  uint32_t total_length;
+  uint32_t offset;
   uint8_t buffer[];
 };
 
@@ -56,10 +64,55 @@ struct __attribute__((__packed__)) ImagePacket {
   uint32_t id;
   int16_t width;
   int16_t height;
+  uint8_t format;
+  uint8_t bitmap_format;
+  uint16_t pixels_length;
+  uint8_t pixels[];
+};
+
+//! Largest segmented message that will be reassembled: a full screen 8-bit image, with room for
+//! the header and a PNG palette. Aplite only shows 1-bit images.
+#define MAX_SEGMENTED_LENGTH \
+    IF_APLITE_ELSE(8 * 1024, PBL_DISPLAY_WIDTH * PBL_DISPLAY_HEIGHT + sizeof(ImagePacket) + 1024)
+
+//! A PNG covering part of a progressively delivered image, each of its pixels `scale` wide
+typedef struct ImageTilePacket ImageTilePacket;
+
+struct __attribute__((__packed__)) ImageTilePacket {
+  Packet packet;
+  uint32_t id;
+  int16_t width;
+  int16_t height;
+  int16_t x;
+  int16_t y;
+  uint8_t scale;
   uint16_t pixels_length;
   uint8_t pixels[];
 };
 
+typedef struct MsgStatsPacket MsgStatsPacket;
+
+struct __attribute__((__packed__)) MsgStatsPacket {
+  Packet packet;
+  uint16_t queue_depth;
+  uint16_t max_queue_depth;
+  uint32_t num_sent_messages;
+  uint32_t num_retries;
+  uint32_t avg_queue_ms;
+  uint32_t max_queue_ms;
+  uint32_t num_dropped_packets;
+  uint32_t num_unknown_packets;
+  uint32_t num_malformed_packets;
+  uint32_t num_dropped_messages;
+  uint32_t num_out_of_order_messages;
+  uint32_t image_bytes;
+  uint32_t image_budget;
+  uint16_t num_images;
+  uint32_t num_image_hits;
+  uint32_t num_image_misses;
+  uint32_t num_image_evictions;
+};
+
 typedef struct VibePacket VibePacket;
 
 struct __attribute__((__packed__)) VibePacket {
@@ -94,14 +147,6 @@ static PendingScroll s_pending_scroll = { NULL, 0, false, NULL, 0 };
 #define SCROLL_RETRY_DELAY_MS 100
 #define SCROLL_MAX_RETRIES 50  // 5 seconds max wait
 
-typedef struct CommandHandlerEntry CommandHandlerEntry;
-
-struct CommandHandlerEntry {
-  int16_t start_type;
-  int16_t end_type;
-  PacketHandler handler;
-};
-
 static void handle_packet(Simply *simply, Packet *packet);
 
 bool simply_msg_has_communicated() {
@@ -117,62 +162,99 @@ static void destroy_packet(SimplyMsg *self, SimplyPacket *packet) {
   free(packet);
 }
 
-static void add_receive_packet(SimplyMsg *self, SegmentPacket *packet) {
-  size_t size = packet->packet.length;
-  Packet *copy = malloc(size);
-  memcpy(copy, packet, size);
-  SimplyPacket *node = malloc0(sizeof(*node));
-  node->length = size;
-  node->buffer = copy;
-  list1_prepend(&self->receive_queue, &node->node);
+static void reset_reassembly(SimplyMsg *self) {
+  free(self->receive_buffer);
+  self->receive_buffer = NULL;
+  self->receive_length = 0;
+  self->receive_offset = 0;
 }
 
-static void handle_receive_queue(SimplyMsg *self, SegmentPacket *packet) {
-  size_t total_length = packet->packet.length - sizeof(SegmentPacket);
-  for (List1Node *walk = self->receive_queue; walk; walk = walk->next) {
-    total_length += ((SimplyPacket*) walk)->length - sizeof(SegmentPacket);
-  }
+static void fail_reassembly(SimplyMsg *self, const char *reason) {
+  APP_LOG(APP_LOG_LEVEL_WARNING, "Dropping %u byte message: %s",
+          (unsigned int) self->receive_length, reason);
+  reset_reassembly(self);
+  self->receive_failed = true;
+  self->stats.num_dropped_messages++;
+}
 
-  void *buffer = malloc(total_length);
-  void *cursor = buffer + total_length;
-  SegmentPacket *other = packet;
-  SimplyPacket *walk = NULL;
-  while (true) {
-    size_t copy_size = other->packet.length - sizeof(SegmentPacket);
-    cursor -= copy_size;
-    memcpy(cursor, other->buffer, copy_size);
+static void begin_reassembly(SimplyMsg *self, uint32_t total_length) {
+  reset_reassembly(self);
+  self->receive_failed = false;
+  self->receive_length = total_length;
 
-    if (walk) {
-      list1_remove(&self->receive_queue, &walk->node);
-      destroy_packet(self, walk);
+  if (total_length < sizeof(Packet) || total_length > MAX_SEGMENTED_LENGTH) {
+    fail_reassembly(self, "bad length");
+    return;
+  }
+
+  while (!(self->receive_buffer = malloc(total_length))) {
+    if (!simply_res_evict_image(self->simply->res)) {
+      fail_reassembly(self, "out of memory");
+      return;
     }
+  }
+}
 
-    walk = (SimplyPacket*) self->receive_queue;
-    if (!walk) {
-      break;
+static void handle_segment_packet(Simply *simply, Packet *data) {
+  SimplyMsg *self = simply->msg;
+  SegmentPacket *packet = (SegmentPacket*) data;
+  if (data->length < sizeof(SegmentPacket)) {
+    self->stats.num_malformed_packets++;
+    return;
+  }
+
+  if (packet->offset == 0) {
+    begin_reassembly(self, packet->total_length);
+  }
+
+  if (!self->receive_failed) {
+    const size_t segment_length = data->length - sizeof(SegmentPacket);
+    if (!self->receive_buffer || packet->offset != self->receive_offset ||
+        packet->total_length != self->receive_length ||
+        self->receive_offset + segment_length > self->receive_length) {
+      fail_reassembly(self, "out of sequence");
+    } else {
+      memcpy(self->receive_buffer + self->receive_offset, packet->buffer, segment_length);
+      self->receive_offset += segment_length;
     }
+  }
 
-    other = walk->buffer;
+  if (!packet->is_last) {
+    return;
   }
 
-  handle_packet(self->simply, buffer);
+  if (!self->receive_failed && self->receive_offset != self->receive_length) {
+    fail_reassembly(self, "truncated");
+  }
 
-  free(buffer);
-}
+  // Detach the message so that its handler is free to start another reassembly
+  uint8_t *buffer = self->receive_buffer;
+  self->receive_buffer = NULL;
+  reset_reassembly(self);
+  self->receive_failed = false;
 
-static void handle_segment_packet(Simply *simply, Packet *data) {
-  SegmentPacket *packet = (SegmentPacket*) data;
-  if (packet->is_last) {
-    handle_receive_queue(simply->msg, packet);
-  } else {
-    add_receive_packet(simply->msg, packet);
+  if (buffer) {
+    handle_packet(simply, (Packet*) buffer);
+    free(buffer);
   }
 }
 
 static void handle_image_packet(Simply *simply, Packet *data) {
   ImagePacket *packet = (ImagePacket*) data;
-  simply_res_add_image(simply->res, packet->id, packet->width, packet->height, packet->pixels,
-                       packet->pixels_length);
+  simply_res_add_image(simply->res, packet->id, packet->width, packet->height, packet->format,
+                       packet->bitmap_format, packet->pixels, packet->pixels_length);
+}
+
+static void handle_image_tile_packet(Simply *simply, Packet *data) {
+  ImageTilePacket *packet = (ImageTilePacket*) data;
+  if (data->length < sizeof(ImageTilePacket) ||
+      data->length - sizeof(ImageTilePacket) < packet->pixels_length) {
+    simply->msg->stats.num_malformed_packets++;
+    return;
+  }
+  simply_res_add_image_tile(simply->res, packet->id, GSize(packet->width, packet->height),
+                            GPoint(packet->x, packet->y), packet->scale, packet->pixels,
+                            packet->pixels_length);
 }
 
 static void handle_vibe_packet(Simply *simply, Packet *data) {
@@ -193,6 +275,34 @@ static void handle_light_packet(Simply *simply, Packet *data) {
   }
 }
 
+static void handle_get_msg_stats_packet(Simply *simply, Packet *data) {
+  const SimplyMsgStats *stats = &simply->msg->stats;
+  const SimplyRes *res = simply->res;
+  const uint32_t num_dequeued = stats->num_sent_packets;
+  MsgStatsPacket packet = {
+    .packet.type = CommandMsgStats,
+    .packet.length = sizeof(packet),
+    .queue_depth = stats->queue_depth,
+    .max_queue_depth = stats->max_queue_depth,
+    .num_sent_messages = stats->num_sent_messages,
+    .num_retries = stats->num_retries,
+    .avg_queue_ms = num_dequeued ? stats->total_queue_ms / num_dequeued : 0,
+    .max_queue_ms = stats->max_queue_ms,
+    .num_dropped_packets = stats->num_dropped_packets,
+    .num_unknown_packets = stats->num_unknown_packets,
+    .num_malformed_packets = stats->num_malformed_packets,
+    .num_dropped_messages = stats->num_dropped_messages,
+    .num_out_of_order_messages = stats->num_out_of_order_messages,
+    .image_bytes = res->image_bytes,
+    .image_budget = res->image_budget,
+    .num_images = res->images.size,
+    .num_image_hits = res->stats.num_image_hits,
+    .num_image_misses = res->stats.num_image_misses,
+    .num_image_evictions = res->stats.num_image_evictions,
+  };
+  simply_msg_send_packet(&packet.packet);
+}
+
 static bool simply_base_handle_packet(Simply *simply, Packet *packet) {
   switch (packet->type) {
     case CommandSegment:
@@ -201,12 +311,18 @@ static bool simply_base_handle_packet(Simply *simply, Packet *packet) {
     case CommandImagePacket:
       handle_image_packet(simply, packet);
       return true;
+    case CommandImageTile:
+      handle_image_tile_packet(simply, packet);
+      return true;
     case CommandVibe:
       handle_vibe_packet(simply, packet);
       return true;
     case CommandLight:
       handle_light_packet(simply, packet);
       return true;
+    case CommandGetMsgStats:
+      handle_get_msg_stats_packet(simply, packet);
+      return true;
   }
   return false;
 }
@@ -306,27 +422,104 @@ static void handle_scroll_message(Simply *simply, DictionaryIterator *iter) {
   }
 }
 
+typedef bool (*PacketDispatcher)(Simply *simply, Packet *packet);
+
+//! Inbound commands mapped to the module that handles them.
+//! Outbound-only commands are left empty and are counted as unknown if received.
+static const PacketDispatcher s_dispatchers[NumCommands] = {
+  [CommandSegment] = simply_base_handle_packet,
+  [CommandReady] = simply_wakeup_handle_packet,
+  [CommandWakeupSet] = simply_wakeup_handle_packet,
+  [CommandWakeupCancel] = simply_wakeup_handle_packet,
+  [CommandWindowShow] = simply_window_stack_handle_packet,
+  [CommandWindowHide] = simply_window_stack_handle_packet,
+  [CommandWindowProps] = simply_window_handle_packet,
+  [CommandWindowButtonConfig] = simply_window_handle_packet,
+  [CommandWindowStatusBar] = simply_window_handle_packet,
+  [CommandWindowActionBar] = simply_window_handle_packet,
+  [CommandImagePacket] = simply_base_handle_packet,
+  [CommandCardClear] = simply_ui_handle_packet,
+  [CommandCardText] = simply_ui_handle_packet,
+  [CommandCardImage] = simply_ui_handle_packet,
+  [CommandCardStyle] = simply_ui_handle_packet,
+  [CommandVibe] = simply_base_handle_packet,
+  [CommandLight] = simply_base_handle_packet,
+  [CommandAccelPeek] = simply_accel_handle_packet,
+  [CommandAccelConfig] = simply_accel_handle_packet,
+  [CommandMenuClear] = simply_menu_handle_packet,
+  [CommandMenuClearSection] = simply_menu_handle_packet,
+  [CommandMenuProps] = simply_menu_handle_packet,
+  [CommandMenuSection] = simply_menu_handle_packet,
+  [CommandMenuItem] = simply_menu_handle_packet,
+  [CommandMenuSelection] = simply_menu_handle_packet,
+  [CommandMenuGetSelection] = simply_menu_handle_packet,
+  [CommandStageClear] = simply_stage_handle_packet,
+  [CommandElementInsert] = simply_stage_handle_packet,
+  [CommandElementRemove] = simply_stage_handle_packet,
+  [CommandElementCommon] = simply_stage_handle_packet,
+  [CommandElementRadius] = simply_stage_handle_packet,
+  [CommandElementAngle] = simply_stage_handle_packet,
+  [CommandElementAngle2] = simply_stage_handle_packet,
+  [CommandElementText] = simply_stage_handle_packet,
+  [CommandElementTextStyle] = simply_stage_handle_packet,
+  [CommandElementImage] = simply_stage_handle_packet,
+  [CommandElementAnimate] = simply_stage_handle_packet,
+#if !defined(PBL_PLATFORM_APLITE)
+  [CommandVoiceStart] = simply_voice_handle_packet,
+  [CommandVoiceStop] = simply_voice_handle_packet,
+#endif
+  [CommandGetMsgStats] = simply_base_handle_packet,
+  [CommandMenuItems] = simply_menu_handle_packet,
+  [CommandImageTile] = simply_base_handle_packet,
+  [CommandCalculateTextSizes] = simply_stage_handle_packet,
+};
+
 static void handle_packet(Simply *simply, Packet *packet) {
-  if (simply_base_handle_packet(simply, packet)) { return; }
-  if (simply_wakeup_handle_packet(simply, packet)) { return; }
-  if (simply_window_stack_handle_packet(simply, packet)) { return; }
-  if (simply_window_handle_packet(simply, packet)) { return; }
-  if (simply_ui_handle_packet(simply, packet)) { return; }
-  if (simply_accel_handle_packet(simply, packet)) { return; }
-  if (simply_voice_handle_packet(simply, packet)) { return; }
-  if (simply_menu_handle_packet(simply, packet)) { return; }
-  if (simply_stage_handle_packet(simply, packet)) { return; }
+  const PacketDispatcher dispatcher =
+      (packet->type < NumCommands) ? s_dispatchers[packet->type] : NULL;
+  if (!dispatcher || !dispatcher(simply, packet)) {
+    simply->msg->stats.num_unknown_packets++;
+  }
+}
+
+//! Accepts only the next message in the phone's sequence. Early messages were sent past a
+//! message that failed and duplicates were already applied; the phone resends from the failure.
+static bool accept_sequence(SimplyMsg *self, DictionaryIterator *iter) {
+  Tuple *seq_tuple = dict_find(iter, MESSAGE_KEY_SEQUENCE);
+  if (!seq_tuple) {
+    return true;
+  }
+
+  const uint16_t seq = seq_tuple->value->int32;
+  Tuple *session_tuple = dict_find(iter, MESSAGE_KEY_SESSION);
+  if (session_tuple && (uint32_t) session_tuple->value->int32 != self->receive_session) {
+    self->receive_session = session_tuple->value->int32;
+    self->receive_seq = seq;
+  }
+
+  if (seq != self->receive_seq) {
+    self->stats.num_out_of_order_messages++;
+    return false;
+  }
+
+  self->receive_seq++;
+  return true;
 }
 
 static void received_callback(DictionaryIterator *iter, void *context) {
+  Simply *simply = context;
+
   // Check if this is a scroll message
   Tuple *scroll_y_tuple = dict_find(iter, MESSAGE_KEY_SCROLL_Y);
   if (scroll_y_tuple) {
-    Simply *simply = context;
     handle_scroll_message(simply, iter);
     return;
   }
 
+  if (!accept_sequence(simply->msg, iter)) {
+    return;
+  }
+
   Tuple *tuple = dict_find(iter, 0);
   if (!tuple) {
     return;
@@ -342,7 +535,13 @@ static void received_callback(DictionaryIterator *iter, void *context) {
   uint8_t *buffer = tuple->value->data;
   while (true) {
     Packet *packet = (Packet*) buffer;
-    handle_packet(context, packet);
+    if (length < sizeof(Packet) || packet->length > length ||
+        (packet->length && packet->length < sizeof(Packet))) {
+      simply->msg->stats.num_malformed_packets++;
+      break;
+    }
+
+    handle_packet(simply, packet);
 
     if (packet->length == 0) {
       break;
@@ -399,6 +598,12 @@ SimplyMsg *simply_msg_create(Simply *simply) {
 
   simply->msg = self;
 
+  // Seed the retry jitter, rand() repeats the same sequence on every launch otherwise
+  time_t now_s;
+  uint16_t now_ms_part;
+  time_ms(&now_s, &now_ms_part);
+  srand((unsigned int) now_s * 1000 + now_ms_part);
+
   app_message_open(APP_MSG_SIZE_INBOUND, APP_MSG_SIZE_OUTBOUND);
 
   app_message_set_context(simply);
@@ -418,6 +623,8 @@ void simply_msg_destroy(SimplyMsg *self) {
 
   app_message_deregister_callbacks();
 
+  reset_reassembly(self);
+
   self->simply->msg = NULL;
 
   free(self);
@@ -436,43 +643,117 @@ bool simply_msg_send(uint8_t *buffer, size_t length) {
   return send_msg(buffer, length);
 }
 
-static void make_multi_packet(SimplyMsg *self, SimplyPacket *packet) {
+static uint32_t prv_get_milliseconds(void) {
+  time_t now_s;
+  uint16_t now_ms_part;
+  time_ms(&now_s, &now_ms_part);
+  return ((uint32_t) now_s) * 1000 + now_ms_part;
+}
+
+static SimplyMsgLane prv_get_packet_lane(Packet *packet) {
+  switch (packet->type) {
+    // The phone routes input to the window it believes is on top, so window changes and menu
+    // selection moves have to stay in order with the input that follows them
+    case CommandWindowShowEvent:
+    case CommandWindowHideEvent:
+    case CommandMenuSelectionEvent:
+    case CommandClick:
+    case CommandLongClick:
+    case CommandMenuSelect:
+    case CommandMenuLongSelect:
+      return SimplyMsgLaneInput;
+    case CommandAccelData:
+      return SimplyMsgLaneBulk;
+  }
+  return SimplyMsgLaneDefault;
+}
+
+static void queue_push(SimplyMsgQueue *queue, List1Node *node) {
+  node->next = NULL;
+  if (queue->tail) {
+    queue->tail->next = node;
+  } else {
+    queue->head = node;
+  }
+  queue->tail = node;
+  queue->length++;
+}
+
+static List1Node *queue_pop(SimplyMsgQueue *queue) {
+  List1Node *node = queue->head;
+  if (!node) {
+    return NULL;
+  }
+  queue->head = node->next;
+  if (!queue->head) {
+    queue->tail = NULL;
+  }
+  queue->length--;
+  node->next = NULL;
+  return node;
+}
+
+static void dequeue_packet(SimplyMsg *self, SimplyMsgLane lane, uint32_t now_ms) {
+  SimplyPacket *packet = (SimplyPacket*) queue_pop(&self->send_queues[lane]);
   if (!packet) {
     return;
   }
+  SimplyMsgStats *stats = &self->stats;
+  const uint32_t queue_ms = now_ms - packet->queued_ms;
+  stats->queue_depth--;
+  stats->num_sent_packets++;
+  stats->total_queue_ms += queue_ms;
+  stats->max_queue_ms = MAX(stats->max_queue_ms, queue_ms);
+  destroy_packet(self, packet);
+}
+
+static void make_multi_packet(SimplyMsg *self) {
+  // Measure the batch in lane priority order, up to the first packet that doesn't fit
+  const size_t max_length = APP_MSG_SIZE_OUTBOUND - 2 * sizeof(Tuple);
   size_t length = 0;
-  SimplyPacket *last;
-  for (SimplyPacket *walk = packet;;) {
-    length += walk->length;
-    SimplyPacket *next = (SimplyPacket*) walk->node.next;
-    if (!next || length + next->length > APP_MSG_SIZE_OUTBOUND - 2 * sizeof(Tuple)) {
-      last = next;
-      break;
+  for (SimplyMsgLane lane = 0; lane < SimplyMsgNumLanes; lane++) {
+    for (List1Node *walk = self->send_queues[lane].head; walk; walk = walk->next) {
+      const size_t packet_length = ((SimplyPacket*) walk)->length;
+      if (length && length + packet_length > max_length) {
+        goto measured;
+      }
+      length += packet_length;
     }
-    walk = next;
+  }
+measured:
+  if (!length) {
+    return;
   }
   uint8_t *buffer = malloc(length);
   if (!buffer) {
     return;
   }
-  uint8_t *cursor = buffer;
-  for (SimplyPacket *walk = packet; walk && walk != last;) {
-    memcpy(cursor, walk->buffer, walk->length);
-    cursor += walk->length;
-    SimplyPacket *next = (SimplyPacket*) walk->node.next;
-    list1_remove(&self->send_queue, &walk->node);
-    destroy_packet(self, walk);
-    walk = next;
+  // Consume the same packets in the same order
+  const uint32_t now_ms = prv_get_milliseconds();
+  size_t offset = 0;
+  for (SimplyMsgLane lane = 0; offset < length;) {
+    SimplyPacket *packet = (SimplyPacket*) self->send_queues[lane].head;
+    if (!packet) {
+      lane++;
+      continue;
+    }
+    memcpy(buffer + offset, packet->buffer, packet->length);
+    offset += packet->length;
+    dequeue_packet(self, lane, now_ms);
   }
   self->send_buffer = buffer;
   self->send_length = length;
 }
 
+static uint32_t prv_jitter(uint32_t delay_ms) {
+  return rand() % (delay_ms / 4 + 1);
+}
+
 static void send_msg_retry(void *data) {
   SimplyMsg *self = data;
   self->send_timer = NULL;
   if (!self->send_buffer) {
-    make_multi_packet(self, (SimplyPacket*) self->send_queue);
+    make_multi_packet(self);
   }
   if (!self->send_buffer) {
     return;
@@ -481,10 +762,13 @@ static void send_msg_retry(void *data) {
     free(self->send_buffer);
     self->send_buffer = NULL;
     self->send_delay_ms = SEND_DELAY_MS;
+    self->stats.num_sent_messages++;
   } else {
-    self->send_delay_ms *= 2;
+    self->send_delay_ms = MIN(MAX(self->send_delay_ms, SEND_DELAY_MS) * 2, SEND_MAX_DELAY_MS);
+    self->stats.num_retries++;
   }
-  self->send_timer = app_timer_register(self->send_delay_ms, send_msg_retry, self);
+  self->send_timer = app_timer_register(self->send_delay_ms + prv_jitter(self->send_delay_ms),
+                                        send_msg_retry, self);
 }
 
 static SimplyPacket *add_packet(SimplyMsg *self, Packet *buffer) {
@@ -496,8 +780,19 @@ static SimplyPacket *add_packet(SimplyMsg *self, Packet *buffer) {
   *packet = (SimplyPacket) {
     .length = buffer->length,
     .buffer = buffer,
+    .queued_ms = prv_get_milliseconds(),
   };
-  list1_append(&self->send_queue, &packet->node);
+  const SimplyMsgLane lane = prv_get_packet_lane(buffer);
+  SimplyMsgStats *stats = &self->stats;
+  if (lane == SimplyMsgLaneBulk && self->send_queues[lane].length >= MAX_BULK_QUEUE_LENGTH) {
+    // Bulk data is superseded by newer samples, drop the oldest rather than grow the queue
+    destroy_packet(self, (SimplyPacket*) queue_pop(&self->send_queues[lane]));
+    stats->queue_depth--;
+    stats->num_dropped_packets++;
+  }
+  queue_push(&self->send_queues[lane], &packet->node);
+  stats->queue_depth++;
+  stats->max_queue_depth = MAX(stats->max_queue_depth, stats->queue_depth);
   if (self->send_delay_ms <= SEND_DELAY_MS) {
     if (self->send_timer) {
       app_timer_cancel(self->send_timer);
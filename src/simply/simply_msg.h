@@ -11,17 +11,60 @@
 // Message keys for AppMessage
 #define MESSAGE_KEY_SCROLL_Y 1000
 #define MESSAGE_KEY_ANIMATED 1001
+#define MESSAGE_KEY_SEQUENCE 1
+#define MESSAGE_KEY_SESSION 2
+
+//! Outbound priority lanes, sent in order
+typedef enum SimplyMsgLane SimplyMsgLane;
+
+enum SimplyMsgLane {
+  SimplyMsgLaneInput = 0,
+  SimplyMsgLaneDefault,
+  SimplyMsgLaneBulk,
+  SimplyMsgNumLanes,
+};
+
+typedef struct SimplyMsgQueue SimplyMsgQueue;
+
+struct SimplyMsgQueue {
+  List1Node *head;
+  List1Node *tail;
+  uint16_t length;
+};
+
+typedef struct SimplyMsgStats SimplyMsgStats;
+
+struct SimplyMsgStats {
+  uint16_t queue_depth;
+  uint16_t max_queue_depth;
+  uint32_t num_sent_messages;
+  uint32_t num_sent_packets;
+  uint32_t num_retries;
+  uint32_t total_queue_ms;
+  uint32_t max_queue_ms;
+  uint32_t num_dropped_packets;
+  uint32_t num_unknown_packets;
+  uint32_t num_malformed_packets;
+  uint32_t num_dropped_messages;
+  uint32_t num_out_of_order_messages;
+};
 
 typedef struct SimplyMsg SimplyMsg;
 
 struct SimplyMsg {
   Simply *simply;
-  List1Node *send_queue;
-  List1Node *receive_queue;
+  SimplyMsgQueue send_queues[SimplyMsgNumLanes];
+  uint8_t *receive_buffer;
+  uint32_t receive_length;
+  uint32_t receive_offset;
+  bool receive_failed;
+  uint32_t receive_session;
+  uint16_t receive_seq;
   uint32_t send_delay_ms;
   AppTimer *send_timer;
   uint8_t *send_buffer;
   size_t send_length;
+  SimplyMsgStats stats;
 };
 
 typedef struct SimplyPacket SimplyPacket;
@@ -29,6 +72,7 @@ typedef struct SimplyPacket SimplyPacket;
 struct SimplyPacket {
   List1Node node;
   uint16_t length;
+  uint32_t queued_ms;
   void *buffer;
 };
 
@@ -58,7 +58,15 @@ enum Command {
   CommandVoiceStart,
   CommandVoiceStop,
   CommandVoiceData,
+  //! Retired single text size request, superseded by CommandCalculateTextSizes
   CommandCalculateTextSize,
   CommandCalculateTextSizeResponse,
+  CommandGetMsgStats,
+  CommandMsgStats,
+  CommandMenuItems,
+  CommandImageEvicted,
+  CommandImageTile,
+  CommandCalculateTextSizes,
+  CommandCalculateTextSizesResponse,
   NumCommands,
 };
@@ -1,15 +1,54 @@
 #include "simply_res.h"
 
+#include "simply_msg.h"
+
 #include "util/color.h"
 #include "util/graphics.h"
+#include "util/math.h"
 #include "util/memory.h"
 #include "util/sdk.h"
 #include "util/window.h"
 
 #include <pebble.h>
 
-static bool id_filter(List1Node *node, void *data) {
-  return (((SimplyResItemCommon*) node)->id == (uint32_t)(uintptr_t) data);
+//! Pixel format of progressively delivered images
+#define IMAGE_TILE_FORMAT IF_APLITE_ELSE(GBitmapFormat1Bit, GBitmapFormat8Bit)
+
+//! An icon in the atlas, as written by waftools/icon_atlas.py
+typedef struct IconAtlasEntry IconAtlasEntry;
+
+struct __attribute__((__packed__)) IconAtlasEntry {
+  uint16_t id;
+  uint8_t x;
+  uint8_t y;
+  uint8_t width;
+  uint8_t height;
+};
+
+//! Sent for every phone image the watch drops, id 0 means all of them
+typedef struct ImageEvictedPacket ImageEvictedPacket;
+
+struct __attribute__((__packed__)) ImageEvictedPacket {
+  Packet packet;
+  uint32_t id;
+};
+
+static SimplyImage *find_image(SimplyRes *self, uint32_t id) {
+  return (SimplyImage *)lru_find(&self->images, id);
+}
+
+static SimplyFont *find_font(SimplyRes *self, uint32_t id) {
+  return (SimplyFont *)lru_find(&self->fonts, id);
+}
+
+static void destroy_icon_atlas(SimplyRes *self) {
+  if (!self->icon_atlas) {
+    return;
+  }
+  gbitmap_destroy(self->icon_atlas);
+  self->icon_atlas = NULL;
+  self->image_bytes -= self->icon_atlas_size;
+  self->icon_atlas_size = 0;
 }
 
 static void destroy_image(SimplyRes *self, SimplyImage *image) {
@@ -17,10 +56,38 @@ static void destroy_image(SimplyRes *self, SimplyImage *image) {
     return;
   }
 
-  list1_remove(&self->images, &image->node);
+  lru_remove(&self->images, &image->node);
+  self->image_bytes -= image->size;
   gbitmap_destroy(image->bitmap);
   free(image->palette);
+  const bool is_atlas_view = image->is_atlas_view;
   free(image);
+  // Without views the atlas only stays loaded while it fits the budget
+  if (is_atlas_view && --self->num_atlas_views == 0 &&
+      self->image_bytes + self->font_bytes > self->image_budget) {
+    destroy_icon_atlas(self);
+  }
+}
+
+static void report_eviction(SimplyRes *self, uint32_t id) {
+  if (self->is_eviction_report_lost) {
+    // A previous report could not be queued, the phone has to assume everything is gone
+    id = 0;
+  }
+  ImageEvictedPacket packet = {
+    .packet.type = CommandImageEvicted,
+    .packet.length = sizeof(packet),
+    .id = id,
+  };
+  self->is_eviction_report_lost = !simply_msg_send_packet(&packet.packet);
+}
+
+static void evict_image(SimplyRes *self, SimplyImage *image) {
+  const uint32_t id = image->id;
+  destroy_image(self, image);
+  if (id > self->num_bundled_res) {
+    report_eviction(self, id);
+  }
 }
 
 static void destroy_font(SimplyRes *self, SimplyFont *font) {
@@ -28,7 +95,8 @@ static void destroy_font(SimplyRes *self, SimplyFont *font) {
     return;
   }
 
-  list1_remove(&self->fonts, &font->node);
+  lru_remove(&self->fonts, &font->node);
+  self->font_bytes -= font->size;
   fonts_unload_custom_font(font->font);
   free(font);
 }
@@ -47,43 +115,120 @@ static void setup_image(SimplyImage *image) {
   image->palette = palette_copy;
 }
 
-bool simply_res_evict_image(SimplyRes *self) {
-  SimplyImage *last_image = (SimplyImage *)list1_last(self->images);
-  if (!last_image) {
+//! The least recently used image that is neither pinned nor `keep`
+static SimplyImage *prv_get_evictable_image(SimplyRes *self, SimplyImage *keep) {
+  for (LruNode *node = lru_last(&self->images); node; node = node->prev) {
+    SimplyImage *image = (SimplyImage *)node;
+    if (image != keep && !image->num_pins) {
+      return image;
+    }
+  }
+  return NULL;
+}
+
+//! Evicts an unused atlas, else the least recently used image that is neither pinned nor `keep`
+static bool prv_evict_image_except(SimplyRes *self, SimplyImage *keep) {
+  // An atlas without views holds no visible icon, it goes before any image
+  if (self->icon_atlas && !self->num_atlas_views) {
+    destroy_icon_atlas(self);
+    return true;
+  }
+
+  SimplyImage *image = prv_get_evictable_image(self, keep);
+  if (!image) {
     return false;
   }
 
-  destroy_image(self, last_image);
+  evict_image(self, image);
+  self->stats.num_image_evictions++;
   return true;
 }
 
+bool simply_res_evict_image(SimplyRes *self) {
+  return prv_evict_image_except(self, NULL);
+}
+
+void simply_res_pin_image(SimplyRes *self, SimplyImage *image) {
+  if (image) {
+    image->num_pins++;
+  }
+}
+
+void simply_res_unpin_image(SimplyRes *self, uint32_t id) {
+  // The image may have been removed or replaced by the phone while pinned
+  SimplyImage *image = id ? find_image(self, id) : NULL;
+  if (image && image->num_pins) {
+    image->num_pins--;
+  }
+}
+
+static size_t prv_palette_size(GBitmapFormat format) {
+  switch (format) {
+    case GBitmapFormat1BitPalette: return 2;
+    case GBitmapFormat2BitPalette: return 4;
+    case GBitmapFormat4BitPalette: return 16;
+    default: return 0;
+  }
+}
+
+static int prv_bits_per_pixel(GBitmapFormat format) {
+  switch (format) {
+    case GBitmapFormat1Bit: return 1;
+    case GBitmapFormat1BitPalette: return 1;
+    case GBitmapFormat2BitPalette: return 2;
+    case GBitmapFormat4BitPalette: return 4;
+    default: return 8;
+  }
+}
+
+//! Bytes held by an image: its struct, pixel rows and palettes
+static size_t prv_image_size(SimplyImage *image) {
+  const size_t palette_copy_size = image->palette ? 2 * sizeof(GColor8) : 0;
+  if (image->is_atlas_view) {
+    // Pixels and palette belong to the atlas
+    return sizeof(*image) + palette_copy_size;
+  }
+  GBitmap *bitmap = image->bitmap;
+  const GRect bounds = gbitmap_get_bounds(bitmap);
+  return sizeof(*image) + gbitmap_get_bytes_per_row(bitmap) * bounds.size.h +
+      prv_palette_size(gbitmap_get_format(bitmap)) + palette_copy_size;
+}
+
+//! Evicts least recently used images, other than `keep`, until images and fonts fit the budget
+static void prv_trim_images(SimplyRes *self, SimplyImage *keep) {
+  while (self->image_bytes + self->font_bytes > self->image_budget) {
+    if (!prv_evict_image_except(self, keep)) {
+      return;
+    }
+  }
+}
+
+void simply_res_set_image_budget(SimplyRes *self, size_t budget) {
+  self->image_budget = budget;
+  prv_trim_images(self, NULL);
+}
+
 static void add_image(SimplyRes *self, SimplyImage *image) {
-  list1_prepend(&self->images, &image->node);
+  lru_insert(&self->images, &image->node, image->id);
 
   setup_image(image);
 
+  image->size = prv_image_size(image);
+  self->image_bytes += image->size;
+  prv_trim_images(self, image);
+
   window_stack_schedule_top_window_render();
 }
 
 typedef GBitmap *(*GBitmapCreator)(SimplyImage *image, void *data);
 
 static SimplyImage *create_image(SimplyRes *self, GBitmapCreator creator, void *data) {
-  // On APLITE, proactively evict images before attempting allocation
-  // to prevent malloc failures and crashes due to severe memory constraints
-  #if defined(PBL_PLATFORM_APLITE)
-    // On APLITE, only evict if we have more than 4 images cached
-    int image_count = 0;
-    List1Node *node = self->images;
-    while (node) {
-      image_count++;
-      node = node->next;
-    }
-
-    // Only evict if cache is getting full (more than 4 images)
-    if (image_count > 4) {
-      simply_res_evict_image(self);
+  // Keep headroom on the heap before decoding, malloc failing is the last resort
+  while (heap_bytes_free() < IMAGE_HEAP_HEADROOM) {
+    if (!simply_res_evict_image(self)) {
+      break;
     }
-  #endif
+  }
 
   SimplyImage *image = NULL;
   while (!(image = malloc0(sizeof(*image)))) {
@@ -105,17 +250,86 @@ static SimplyImage *create_image(SimplyRes *self, GBitmapCreator creator, void *
   return image;
 }
 
+static void load_icon_atlas_index(SimplyRes *self) {
+  ResHandle handle = resource_get_handle(RESOURCE_ID_ICON_ATLAS_INDEX);
+  const size_t length = handle ? resource_size(handle) : 0;
+  uint8_t *index = length > sizeof(uint16_t) ? malloc(length) : NULL;
+  if (!index) {
+    return;
+  }
+  resource_load(handle, index, length);
+  uint16_t num_icons;
+  memcpy(&num_icons, index, sizeof(num_icons));
+  self->icon_atlas_index = index;
+  self->num_atlas_icons = MIN(num_icons, (length - sizeof(num_icons)) / sizeof(IconAtlasEntry));
+}
+
+//! Entries are sorted by resource id
+static const IconAtlasEntry *find_atlas_icon(SimplyRes *self, uint32_t id) {
+  if (!self->icon_atlas_index) {
+    return NULL;
+  }
+  const IconAtlasEntry *entries = (IconAtlasEntry *)(self->icon_atlas_index + sizeof(uint16_t));
+  int lo = 0;
+  int hi = self->num_atlas_icons - 1;
+  while (lo <= hi) {
+    const int mid = (lo + hi) / 2;
+    if (entries[mid].id == id) {
+      return &entries[mid];
+    } else if (entries[mid].id < id) {
+      lo = mid + 1;
+    } else {
+      hi = mid - 1;
+    }
+  }
+  return NULL;
+}
+
+typedef struct {
+  SimplyRes *res;
+  uint32_t id;
+} CreateBundledContext;
+
 static GBitmap *create_bitmap_with_id(SimplyImage *image, void *data) {
-  const uint32_t id = (uint32_t)(uintptr_t) data;
-  GBitmap *bitmap = gbitmap_create_with_resource(id);
+  CreateBundledContext *ctx = data;
+  SimplyRes *self = ctx->res;
+  const IconAtlasEntry *entry = find_atlas_icon(self, ctx->id);
+  if (entry && !self->icon_atlas) {
+    self->icon_atlas = gbitmap_create_with_resource(RESOURCE_ID_ICON_ATLAS);
+    if (self->icon_atlas) {
+      const GRect bounds = gbitmap_get_bounds(self->icon_atlas);
+      self->icon_atlas_size = gbitmap_get_bytes_per_row(self->icon_atlas) * bounds.size.h +
+          prv_palette_size(gbitmap_get_format(self->icon_atlas));
+      self->image_bytes += self->icon_atlas_size;
+    }
+  }
+  GBitmap *bitmap = NULL;
+  if (entry && self->icon_atlas) {
+    bitmap = gbitmap_create_as_sub_bitmap(self->icon_atlas,
+                                          GRect(entry->x, entry->y, entry->width, entry->height));
+    if (bitmap) {
+      image->is_atlas_view = true;
+      self->num_atlas_views++;
+    } else if (!self->num_atlas_views) {
+      // Make room for the standalone icon, evicting would only drop and reload the atlas
+      destroy_icon_atlas(self);
+    }
+  }
+  if (!bitmap) {
+    bitmap = gbitmap_create_with_resource(ctx->id);
+  }
   if (bitmap) {
-    image->id = id;
+    image->id = ctx->id;
   }
   return bitmap;
 }
 
 SimplyImage *simply_res_add_bundled_image(SimplyRes *self, uint32_t id) {
-  SimplyImage *image = create_image(self, create_bitmap_with_id, (void*)(uintptr_t) id);
+  CreateBundledContext context = {
+    .res = self,
+    .id = id,
+  };
+  SimplyImage *image = create_image(self, create_bitmap_with_id, &context);
   if (image) {
     add_image(self, image);
   }
@@ -124,6 +338,8 @@ SimplyImage *simply_res_add_bundled_image(SimplyRes *self, uint32_t id) {
 
 typedef struct {
   GSize size;
+  ImageFormat format;
+  GBitmapFormat bitmap_format;
   size_t data_length;
   const uint8_t *data;
 } CreateDataContext;
@@ -143,20 +359,121 @@ SDK_3_USAGE static GBitmap *create_bitmap_with_png_data(SimplyImage *image, void
   return ctx->data ? gbitmap_create_from_png_data(ctx->data, ctx->data_length) : NULL;
 }
 
+//! Bytes per row of raw image data as the phone packs it
+static size_t prv_packed_row_size(GBitmapFormat format, int16_t width) {
+  switch (format) {
+    case GBitmapFormat1Bit: return (width + 31) / 32 * 4;
+    case GBitmapFormat8Bit: return width;
+    default: return (width * prv_bits_per_pixel(format) + 7) / 8;
+  }
+}
+
+//! Expands PackBits style runs into bitmap rows. A control byte below 128 is followed by that
+//! many plus one literal bytes, any other repeats the following byte control - 126 times.
+static void prv_unpack_rle(uint8_t *dest, uint16_t dest_stride, size_t row_size, int16_t num_rows,
+                           const uint8_t *src, size_t src_length) {
+  uint8_t *row = dest;
+  uint8_t * const end = dest + num_rows * dest_stride;
+  size_t col = 0;
+  size_t in = 0;
+  while (in < src_length && row < end) {
+    const uint8_t control = src[in++];
+    const bool is_repeat = (control >= 128);
+    size_t count = is_repeat ? control - 126 : control + 1;
+    while (count-- && in < src_length && row < end) {
+      row[col] = src[in];
+      if (!is_repeat) {
+        in++;
+      }
+      if (++col == row_size) {
+        col = 0;
+        row += dest_stride;
+      }
+    }
+    if (is_repeat) {
+      in++;
+    }
+  }
+}
+
+//! Writes raw rows, preceded by their palette, straight into a blank bitmap
+SDK_3_USAGE static GBitmap *create_bitmap_with_raw_data(SimplyImage *image, void *data) {
+  CreateDataContext *ctx = data;
+  const size_t num_colors = prv_palette_size(ctx->bitmap_format);
+  GColor8 *palette = NULL;
+  if (num_colors) {
+    palette = malloc(num_colors * sizeof(GColor8));
+    if (!palette) {
+      return NULL;
+    }
+    memcpy(palette, ctx->data, num_colors * sizeof(GColor8));
+  }
+
+  GBitmap *bitmap = palette ?
+      gbitmap_create_blank_with_palette(ctx->size, ctx->bitmap_format, palette, true) :
+      gbitmap_create_blank(ctx->size, ctx->bitmap_format);
+  if (!bitmap) {
+    free(palette);
+    return NULL;
+  }
+
+  uint8_t *dest = gbitmap_get_data(bitmap);
+  const uint16_t dest_stride = gbitmap_get_bytes_per_row(bitmap);
+  const size_t row_size = prv_packed_row_size(ctx->bitmap_format, ctx->size.w);
+  const uint8_t *src = ctx->data + num_colors * sizeof(GColor8);
+  const size_t src_length = ctx->data_length - num_colors * sizeof(GColor8);
+  if (ctx->format == ImageFormatRawRle) {
+    prv_unpack_rle(dest, dest_stride, row_size, ctx->size.h, src, src_length);
+  } else {
+    for (int16_t y = 0; y < ctx->size.h; y++) {
+      memcpy(dest + y * dest_stride, src + y * row_size, row_size);
+    }
+  }
+  return bitmap;
+}
+
+//! Whether the packet data holds everything the raw format needs
+static bool prv_is_raw_data_valid(CreateDataContext *ctx) {
+  switch (ctx->bitmap_format) {
+    case GBitmapFormat1Bit:
+    case GBitmapFormat8Bit:
+    case GBitmapFormat2BitPalette:
+    case GBitmapFormat4BitPalette:
+      break;
+    default:
+      return false;
+  }
+  const size_t palette_size = prv_palette_size(ctx->bitmap_format) * sizeof(GColor8);
+  if (ctx->format == ImageFormatRawRle) {
+    return ctx->data_length >= palette_size;
+  }
+  return ctx->data_length >=
+      palette_size + prv_packed_row_size(ctx->bitmap_format, ctx->size.w) * ctx->size.h;
+}
+
 SimplyImage *simply_res_add_image(SimplyRes *self, uint32_t id, int16_t width, int16_t height,
+                                  ImageFormat format, GBitmapFormat bitmap_format,
                                   uint8_t *pixels, uint16_t pixels_length) {
-  SimplyImage *image = (SimplyImage*) list1_find(self->images, id_filter, (void*)(uintptr_t) id);
+  SimplyImage *image = find_image(self, id);
   if (image) {
     destroy_image(self, image);
   }
 
   CreateDataContext context = {
     .size = GSize(width, height),
+    .format = format,
+    .bitmap_format = bitmap_format,
     .data_length = pixels_length,
     .data = pixels,
   };
-  image = IF_SDK_3_ELSE(create_image(self, create_bitmap_with_png_data, &context),
-                        create_image(self, create_bitmap_with_data, &context));
+  GBitmapCreator creator = IF_SDK_3_ELSE(create_bitmap_with_png_data, create_bitmap_with_data);
+  if (IF_SDK_3_ELSE(format != ImageFormatPng, false)) {
+    if (!pixels || !prv_is_raw_data_valid(&context)) {
+      return NULL;
+    }
+    creator = IF_SDK_3_ELSE(create_bitmap_with_raw_data, NULL);
+  }
+  image = create_image(self, creator, &context);
   if (image) {
     image->id = id;
     add_image(self, image);
@@ -164,8 +481,110 @@ SimplyImage *simply_res_add_image(SimplyRes *self, uint32_t id, int16_t width, i
   return image;
 }
 
+static GBitmap *create_blank_bitmap(SimplyImage *image, void *data) {
+  return gbitmap_create_blank(*(GSize *)data, IMAGE_TILE_FORMAT);
+}
+
+//! Color of a pixel in any of the formats a decoded PNG may have
+static GColor8 prv_get_pixel(GBitmap *bitmap, GBitmapFormat format, const uint8_t *row, int x) {
+  switch (format) {
+    case GBitmapFormat1Bit:
+      return ((row[x / 8] >> (x % 8)) & 1) ? GColor8White : GColor8Black;
+    case GBitmapFormat8Bit:
+      return (GColor8) { .argb = row[x] };
+    default: {
+      // Palette indices are packed most significant bits first
+      const int bits = prv_bits_per_pixel(format);
+      const int per_byte = 8 / bits;
+      const int shift = (per_byte - 1 - x % per_byte) * bits;
+      return gbitmap_get_palette(bitmap)[(row[x / per_byte] >> shift) & ((1 << bits) - 1)];
+    }
+  }
+}
+
+static void prv_set_pixel(uint8_t *row, int x, GColor8 color) {
+  if (IMAGE_TILE_FORMAT == GBitmapFormat8Bit) {
+    row[x] = color.argb;
+  } else if (color.r + color.g + color.b >= 5) {
+    // At least half intensity is white
+    row[x / 8] |= 1 << (x % 8);
+  } else {
+    row[x / 8] &= ~(1 << (x % 8));
+  }
+}
+
+//! Copies `tile` into `dest` at `origin`, each tile pixel covering `scale` x `scale` pixels
+static void prv_blit_tile(GBitmap *dest, GBitmap *tile, GPoint origin, int scale) {
+  const GSize dest_size = gbitmap_get_bounds(dest).size;
+  const GSize tile_size = gbitmap_get_bounds(tile).size;
+  const GBitmapFormat tile_format = gbitmap_get_format(tile);
+  uint8_t *dest_data = gbitmap_get_data(dest);
+  const uint8_t *tile_data = gbitmap_get_data(tile);
+  const uint16_t dest_stride = gbitmap_get_bytes_per_row(dest);
+  const uint16_t tile_stride = gbitmap_get_bytes_per_row(tile);
+
+  for (int ty = 0; ty < tile_size.h; ty++) {
+    const uint8_t *tile_row = tile_data + ty * tile_stride;
+    const int y_begin = MAX(origin.y + ty * scale, 0);
+    const int y_end = MIN(origin.y + (ty + 1) * scale, dest_size.h);
+    for (int y = y_begin; y < y_end; y++) {
+      uint8_t *dest_row = dest_data + y * dest_stride;
+      for (int tx = 0; tx < tile_size.w; tx++) {
+        const GColor8 color = prv_get_pixel(tile, tile_format, tile_row, tx);
+        const int x_begin = MAX(origin.x + tx * scale, 0);
+        const int x_end = MIN(origin.x + (tx + 1) * scale, dest_size.w);
+        for (int x = x_begin; x < x_end; x++) {
+          prv_set_pixel(dest_row, x, color);
+        }
+      }
+    }
+  }
+}
+
+SimplyImage *simply_res_add_image_tile(SimplyRes *self, uint32_t id, GSize size, GPoint origin,
+                                       uint8_t scale, uint8_t *pixels, uint16_t pixels_length) {
+  SimplyImage *image = find_image(self, id);
+  if (image) {
+    const GRect bounds = gbitmap_get_bounds(image->bitmap);
+    if (image->is_atlas_view || !gsize_equal(&bounds.size, &size) ||
+        gbitmap_get_format(image->bitmap) != IMAGE_TILE_FORMAT) {
+      // Tiles can only be patched into a blank bitmap of their own
+      destroy_image(self, image);
+      image = NULL;
+    }
+  }
+
+  if (image) {
+    lru_touch(&self->images, &image->node);
+  } else {
+    image = create_image(self, create_blank_bitmap, &size);
+    if (!image) {
+      return NULL;
+    }
+    image->id = id;
+    add_image(self, image);
+  }
+
+  if (!pixels_length) {
+    return image;
+  }
+
+  GBitmap *tile = NULL;
+  while (!(tile = gbitmap_create_from_png_data(pixels, pixels_length))) {
+    if (!prv_evict_image_except(self, image)) {
+      return image;
+    }
+  }
+
+  prv_blit_tile(image->bitmap, tile, origin, scale ? scale : 1);
+  gbitmap_destroy(tile);
+
+  window_stack_schedule_top_window_render();
+  return image;
+}
+
 void simply_res_remove_image(SimplyRes *self, uint32_t id) {
-  SimplyImage *image = (SimplyImage*) list1_find(self->images, id_filter, (void*)(uintptr_t) id);
+  SimplyImage *image = find_image(self, id);
   if (image) {
     destroy_image(self, image);
   }
@@ -175,82 +594,115 @@ SimplyImage *simply_res_auto_image(SimplyRes *self, uint32_t id, bool is_placeho
   if (!id) {
     return NULL;
   }
-  SimplyImage *image = (SimplyImage*) list1_find(self->images, id_filter, (void*)(uintptr_t) id);
+  SimplyImage *image = find_image(self, id);
   if (image) {
+    lru_touch(&self->images, &image->node);
+    self->stats.num_image_hits++;
     return image;
   }
+  self->stats.num_image_misses++;
   if (id <= self->num_bundled_res) {
     return simply_res_add_bundled_image(self, id);
   }
   if (is_placeholder) {
-    return simply_res_add_image(self, id, 0, 0, NULL, 0);
+    return simply_res_add_image(self, id, 0, 0, ImageFormatPng, GBitmapFormat1Bit, NULL, 0);
   }
   return NULL;
 }
 
-GFont simply_res_add_custom_font(SimplyRes *self, uint32_t id) {
-  SimplyFont *font = malloc0(sizeof(*font));
-  if (!font) {
+GFont simply_res_retain_font(SimplyRes *self, uint32_t id) {
+  if (!id || id > self->num_bundled_res) {
     return NULL;
   }
+  SimplyFont *font = find_font(self, id);
+  if (font) {
+    font->num_refs++;
+    return font->font;
+  }
 
   ResHandle handle = resource_get_handle(id);
   if (!handle) {
     return NULL;
   }
 
-  GFont custom_font = fonts_load_custom_font(handle);
-  if (!custom_font) {
-    free(font);
-    return NULL;
+  while (heap_bytes_free() < IMAGE_HEAP_HEADROOM) {
+    if (!simply_res_evict_image(self)) {
+      break;
+    }
   }
 
-  font->id = id;
-  font->font = custom_font;
+  // Glyphs are read from the resource on demand, charge the heap the load actually took
+  const size_t heap_free = heap_bytes_free();
+  const size_t image_bytes = self->image_bytes;
 
-  list1_prepend(&self->fonts, &font->node);
+  while (!(font = malloc0(sizeof(*font)))) {
+    if (!simply_res_evict_image(self)) {
+      return NULL;
+    }
+  }
 
-  window_stack_schedule_top_window_render();
+  GFont custom_font = NULL;
+  while (!(custom_font = fonts_load_custom_font(handle))) {
+    if (!simply_res_evict_image(self)) {
+      free(font);
+      return NULL;
+    }
+  }
+
+  // Count the heap freed by evictions during the load as taken by the font
+  const size_t heap_before = heap_free + (image_bytes - self->image_bytes);
+  const size_t heap_after = heap_bytes_free();
+  const size_t size = MAX(heap_before - MIN(heap_before, heap_after), sizeof(*font));
+
+  font->id = id;
+  font->size = size;
+  font->num_refs = 1;
+  font->font = custom_font;
+  lru_insert(&self->fonts, &font->node, id);
+  self->font_bytes += size;
+  prv_trim_images(self, NULL);
 
   return font->font;
 }
 
-GFont simply_res_auto_font(SimplyRes *self, uint32_t id) {
-  if (!id) {
-    return NULL;
-  }
-  SimplyFont *font = (SimplyFont*) list1_find(self->fonts, id_filter, (void*)(uintptr_t) id);
-  if (font) {
-    return font->font;
+void simply_res_release_font(SimplyRes *self, uint32_t id) {
+  SimplyFont *font = find_font(self, id);
+  if (font && --font->num_refs == 0) {
+    destroy_font(self, font);
   }
-  if (id <= self->num_bundled_res) {
-    return simply_res_add_custom_font(self, id);
-  }
-  return NULL;
 }
 
-void simply_res_clear(SimplyRes *self) {
-  while (self->images) {
-    destroy_image(self, (SimplyImage*) self->images);
+static void destroy_images(SimplyRes *self) {
+  while (self->images.head) {
+    destroy_image(self, (SimplyImage *)self->images.head);
   }
+}
 
-  while (self->fonts) {
-    destroy_font(self, (SimplyFont*) self->fonts);
+static void destroy_fonts(SimplyRes *self) {
+  while (self->fonts.head) {
+    destroy_font(self, (SimplyFont *)self->fonts.head);
   }
 }
 
 SimplyRes *simply_res_create() {
   SimplyRes *self = malloc(sizeof(*self));
-  *self = (SimplyRes) { .images = NULL };
+  *self = (SimplyRes) { .image_budget = IMAGE_CACHE_BUDGET };
+  lru_init(&self->images, self->image_buckets, IMAGE_CACHE_BUCKETS);
+  lru_init(&self->fonts, self->font_buckets, FONT_CACHE_BUCKETS);
 
   while (resource_get_handle(self->num_bundled_res + 1)) {
     ++self->num_bundled_res;
   }
 
+  load_icon_atlas_index(self);
+
   return self;
 }
 
 void simply_res_destroy(SimplyRes *self) {
-  simply_res_clear(self);
+  destroy_images(self);
+  destroy_fonts(self);
+  destroy_icon_atlas(self);
+  free(self->icon_atlas_index);
   free(self);
 }
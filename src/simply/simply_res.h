@@ -3,65 +3,111 @@
 #include "simply.h"
 
 #include "util/color.h"
-#include "util/list1.h"
+#include "util/lru.h"
+#include "util/platform.h"
 
 #include <pebble.h>
 
 #define simply_res_get_image(self, id) simply_res_auto_image(self, id, false)
 
-#define simply_res_get_font(self, id) simply_res_auto_font(self, id)
+//! Default number of bytes decoded images and custom fonts may hold
+#define IMAGE_CACHE_BUDGET IF_APLITE_ELSE(6 * 1024, 48 * 1024)
 
-typedef struct SimplyRes SimplyRes;
+//! Heap left free for everything else, images are evicted rather than eat into it
+#define IMAGE_HEAP_HEADROOM IF_APLITE_ELSE(4 * 1024, 12 * 1024)
 
-struct SimplyRes {
-  List1Node *images;
-  List1Node *fonts;
-  uint32_t num_bundled_res;
+//! Hash buckets of the image cache, a power of two
+#define IMAGE_CACHE_BUCKETS IF_APLITE_ELSE(8, 32)
+
+//! Hash buckets of the font cache, a power of two
+#define FONT_CACHE_BUCKETS 4
+
+//! Encoding of the pixels of an ImagePacket
+typedef enum ImageFormat ImageFormat;
+
+enum ImageFormat {
+  //! A PNG, or 1-bit rows on SDK 2
+  ImageFormatPng = 0,
+  //! The palette of the bitmap format followed by its rows, 1-bit rows padded to 32 bits and
+  //! palettized rows to a whole byte
+  ImageFormatRaw,
+  //! Same as ImageFormatRaw with the rows PackBits compressed
+  ImageFormatRawRle,
 };
 
-typedef struct SimplyResItemCommon SimplyResItemCommon;
+typedef struct SimplyResStats SimplyResStats;
 
-#define SimplyResItemCommonDef { \
-  List1Node node;                \
-  uint32_t id;                   \
-}
+struct SimplyResStats {
+  uint32_t num_image_hits;
+  uint32_t num_image_misses;
+  uint32_t num_image_evictions;
+};
 
-struct SimplyResItemCommon SimplyResItemCommonDef;
+typedef struct SimplyRes SimplyRes;
 
-#define SimplyResItemCommonMember      \
-  union {                              \
-    struct SimplyResItemCommon common; \
-    struct SimplyResItemCommonDef;     \
-  }
+struct SimplyRes {
+  LruTable images;
+  LruNode *image_buckets[IMAGE_CACHE_BUCKETS];
+  size_t image_bytes;
+  size_t image_budget;
+  //! Bundled menu icons packed by waftools/icon_atlas.py, shared by sub bitmap views
+  GBitmap *icon_atlas;
+  //! Bytes of the atlas bitmap, counted in image_bytes while it is loaded
+  size_t icon_atlas_size;
+  uint8_t *icon_atlas_index;
+  uint16_t num_atlas_icons;
+  uint16_t num_atlas_views;
+  LruTable fonts;
+  LruNode *font_buckets[FONT_CACHE_BUCKETS];
+  //! Bytes held by custom fonts, images are trimmed so both fit the image budget
+  size_t font_bytes;
+  uint32_t num_bundled_res;
+  bool is_eviction_report_lost;
+  SimplyResStats stats;
+};
 
 typedef struct SimplyImage SimplyImage;
 
 struct SimplyImage {
-  SimplyResItemCommonMember;
+  LruNode node;
+  uint32_t id;
+  size_t size;
   uint8_t *bitmap_data;
   GBitmap *bitmap;
   GColor8 *palette;
+  //! Holders of the raw bitmap pointer, e.g. the action bar, pinned images are not evicted
+  uint16_t num_pins;
   bool is_palette_black_and_white:1;
+  bool is_atlas_view:1;
 };
 
 typedef struct SimplyFont SimplyFont;
 
+//! A custom font shared by every element that uses it, unloaded with the last reference
 struct SimplyFont {
-  SimplyResItemCommonMember;
+  LruNode node;
+  uint32_t id;
+  size_t size;
+  uint16_t num_refs;
   GFont font;
 };
 
 SimplyRes *simply_res_create();
 void simply_res_destroy(SimplyRes *self);
-void simply_res_clear(SimplyRes *self);
 
 SimplyImage *simply_res_add_bundled_image(SimplyRes *self, uint32_t id);
 SimplyImage *simply_res_add_image(SimplyRes *self, uint32_t id, int16_t width, int16_t height,
+                                  ImageFormat format, GBitmapFormat bitmap_format,
                                   uint8_t *pixels, uint16_t pixels_length);
+SimplyImage *simply_res_add_image_tile(SimplyRes *self, uint32_t id, GSize size, GPoint origin,
+                                       uint8_t scale, uint8_t *pixels, uint16_t pixels_length);
 SimplyImage *simply_res_auto_image(SimplyRes *self, uint32_t id, bool is_placeholder);
 bool simply_res_evict_image(SimplyRes *self);
+void simply_res_pin_image(SimplyRes *self, SimplyImage *image);
+void simply_res_unpin_image(SimplyRes *self, uint32_t id);
+void simply_res_set_image_budget(SimplyRes *self, size_t budget);
 
-GFont simply_res_add_custom_font(SimplyRes *self, uint32_t id);
-GFont simply_res_auto_font(SimplyRes *self, uint32_t id);
+GFont simply_res_retain_font(SimplyRes *self, uint32_t id);
+void simply_res_release_font(SimplyRes *self, uint32_t id);
 
 void simply_res_remove_image(SimplyRes *self, uint32_t id);
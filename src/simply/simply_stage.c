@@ -11,6 +11,7 @@
 #include "util/compat.h"
 #include "util/graphics.h"
 #include "util/inverter_layer.h"
+#include "util/lru.h"
 #include "util/memory.h"
 #include "util/string.h"
 #include "util/window.h"
@@ -109,25 +110,66 @@ struct __attribute__((__packed__)) ElementTextHeightResponsePacket {
   uint16_t height;
 };
 
-typedef struct CalculateTextSizePacket CalculateTextSizePacket;
+//! One measurement of a CalculateTextSizesPacket, followed by its NUL terminated text
+typedef struct TextSizeRequest TextSizeRequest;
 
-struct __attribute__((__packed__)) CalculateTextSizePacket {
-  Packet packet;
+struct __attribute__((__packed__)) TextSizeRequest {
+  uint16_t request_id;
   uint8_t font_key;
   uint16_t width;
   uint8_t overflow_mode;
   uint8_t alignment;
+  //! Including the NUL terminator
+  uint16_t text_length;
   char text[];
 };
 
-typedef struct CalculateTextSizeResponsePacket CalculateTextSizeResponsePacket;
+typedef struct CalculateTextSizesPacket CalculateTextSizesPacket;
 
-struct __attribute__((__packed__)) CalculateTextSizeResponsePacket {
+struct __attribute__((__packed__)) CalculateTextSizesPacket {
   Packet packet;
+  uint8_t num_requests;
+  uint8_t requests[];
+};
+
+typedef struct TextSizeResult TextSizeResult;
+
+struct __attribute__((__packed__)) TextSizeResult {
+  uint16_t request_id;
   uint16_t width;
   uint16_t height;
 };
 
+typedef struct CalculateTextSizesResponsePacket CalculateTextSizesResponsePacket;
+
+struct __attribute__((__packed__)) CalculateTextSizesResponsePacket {
+  Packet packet;
+  uint8_t num_results;
+  TextSizeResult results[];
+};
+
+#define TEXT_SIZE_CACHE_BUCKETS (TEXT_SIZE_CACHE_SIZE / 2)
+
+typedef struct TextSizeEntry TextSizeEntry;
+
+struct TextSizeEntry {
+  LruNode node;
+  uint32_t text_hash;
+  uint16_t width;
+  uint8_t font_key;
+  uint8_t overflow_mode:4;
+  uint8_t alignment:4;
+  GSize size;
+};
+
+//! Recent text measurements keyed by text hash, font, width, overflow mode and alignment
+struct TextSizeCache {
+  LruTable table;
+  LruNode *buckets[TEXT_SIZE_CACHE_BUCKETS];
+  TextSizeEntry entries[TEXT_SIZE_CACHE_SIZE];
+  uint16_t num_entries;
+};
+
 typedef struct ElementAnimatePacket ElementAnimatePacket;
 
 struct __attribute__((__packed__)) ElementAnimatePacket {
@@ -187,6 +229,7 @@ static void destroy_element(SimplyStage *self, SimplyElementCommon *element) {
     default: break;
     case SimplyElementTypeText:
       free(((SimplyElementText*) element)->text);
+      simply_res_release_font(self->window.simply->res, ((SimplyElementText*) element)->custom_font);
       break;
     case SimplyElementTypeInverter:
       inverter_layer_destroy(((SimplyElementInverter*) element)->inverter_layer);
@@ -567,7 +610,6 @@ static void window_appear(Window *window) {
 static void window_disappear(Window *window) {
   SimplyStage *self = window_get_user_data(window);
   if (simply_window_disappear(&self->window)) {
-    simply_res_clear(self->window.simply->res);
     simply_stage_clear(self);
   }
 }
@@ -701,10 +743,17 @@ static void handle_element_text_style_packet(Simply *simply, Packet *data) {
   element->text_color = packet->color;
   element->overflow_mode = packet->overflow_mode;
   element->alignment = packet->alignment;
-  if (packet->custom_font) {
-    element->font = simply_res_get_font(simply->res, packet->custom_font);
-  } else if (packet->system_font[0]) {
-    element->font = fonts_get_system_font(packet->system_font);
+  if (packet->custom_font || packet->system_font[0]) {
+    // Retain before releasing so restyling with the same font does not reload it
+    const uint32_t custom_font = element->custom_font;
+    if (packet->custom_font) {
+      element->font = simply_res_retain_font(simply->res, packet->custom_font);
+      element->custom_font = element->font ? packet->custom_font : 0;
+    } else {
+      element->font = fonts_get_system_font(packet->system_font);
+      element->custom_font = 0;
+    }
+    simply_res_release_font(simply->res, custom_font);
   }
   simply_stage_update(simply->stage);
 }
@@ -737,64 +786,118 @@ static void handle_element_animate_packet(Simply *simply, Packet *data) {
   simply_stage_animate_element(simply->stage, element, animation, packet->frame);
 }
 
-static void handle_calculate_text_size_packet(Simply *simply, Packet *data) {
-  CalculateTextSizePacket *packet = (CalculateTextSizePacket*) data;
-
-  // Get the font based on the font key
-  GFont font;
-  switch(packet->font_key) {
-    case 0: font = fonts_get_system_font(FONT_KEY_GOTHIC_14); break;
-    case 1: font = fonts_get_system_font(FONT_KEY_GOTHIC_14_BOLD); break;
-    case 2: font = fonts_get_system_font(FONT_KEY_GOTHIC_18); break;
-    case 3: font = fonts_get_system_font(FONT_KEY_GOTHIC_18_BOLD); break;
-    case 4: font = fonts_get_system_font(FONT_KEY_GOTHIC_24); break;
-    case 5: font = fonts_get_system_font(FONT_KEY_GOTHIC_24_BOLD); break;
-    case 6: font = fonts_get_system_font(FONT_KEY_GOTHIC_28); break;
-    case 7: font = fonts_get_system_font(FONT_KEY_GOTHIC_28_BOLD); break;
-    case 8: font = fonts_get_system_font(FONT_KEY_BITHAM_30_BLACK); break;
-    case 9: font = fonts_get_system_font(FONT_KEY_BITHAM_42_BOLD); break;
-    case 10: font = fonts_get_system_font(FONT_KEY_BITHAM_42_LIGHT); break;
-    case 11: font = fonts_get_system_font(FONT_KEY_BITHAM_42_MEDIUM_NUMBERS); break;
-    case 12: font = fonts_get_system_font(FONT_KEY_ROBOTO_CONDENSED_21); break;
-    case 13: font = fonts_get_system_font(FONT_KEY_ROBOTO_BOLD_SUBSET_49); break;
-    case 14: font = fonts_get_system_font(FONT_KEY_DROID_SERIF_28_BOLD); break;
-    default: font = fonts_get_system_font(FONT_KEY_GOTHIC_14); break;
-  }
-
-  // Create a frame with the specified width and a very large height
-  // As Katharine Berry suggests, use a very large number for the height
-  GRect frame = GRect(0, 0, packet->width, 10000); // Height is set very large
-
-  // Get the text overflow mode
-  GTextOverflowMode overflow_mode = packet->overflow_mode;
-
-  // Get the text alignment
-  GTextAlignment alignment = packet->alignment;
-
-  // Calculate the text size
-  // Using a very large frame height ensures we get the true content size
-  GSize text_size = graphics_text_layout_get_content_size(
-    packet->text,
-    font,
-    frame,
-    overflow_mode,
-    alignment
-  );
-
+//! Font of a font key shared with the phone's text size requests
+static GFont prv_get_text_size_font(uint8_t font_key) {
+  switch (font_key) {
+    case 0: return fonts_get_system_font(FONT_KEY_GOTHIC_14);
+    case 1: return fonts_get_system_font(FONT_KEY_GOTHIC_14_BOLD);
+    case 2: return fonts_get_system_font(FONT_KEY_GOTHIC_18);
+    case 3: return fonts_get_system_font(FONT_KEY_GOTHIC_18_BOLD);
+    case 4: return fonts_get_system_font(FONT_KEY_GOTHIC_24);
+    case 5: return fonts_get_system_font(FONT_KEY_GOTHIC_24_BOLD);
+    case 6: return fonts_get_system_font(FONT_KEY_GOTHIC_28);
+    case 7: return fonts_get_system_font(FONT_KEY_GOTHIC_28_BOLD);
+    case 8: return fonts_get_system_font(FONT_KEY_BITHAM_30_BLACK);
+    case 9: return fonts_get_system_font(FONT_KEY_BITHAM_42_BOLD);
+    case 10: return fonts_get_system_font(FONT_KEY_BITHAM_42_LIGHT);
+    case 11: return fonts_get_system_font(FONT_KEY_BITHAM_42_MEDIUM_NUMBERS);
+    case 12: return fonts_get_system_font(FONT_KEY_ROBOTO_CONDENSED_21);
+    case 13: return fonts_get_system_font(FONT_KEY_ROBOTO_BOLD_SUBSET_49);
+    case 14: return fonts_get_system_font(FONT_KEY_DROID_SERIF_28_BOLD);
+    default: return fonts_get_system_font(FONT_KEY_GOTHIC_14);
+  }
+}
+
+static uint32_t prv_text_size_key(uint32_t text_hash, uint8_t font_key, uint16_t width,
+                                  uint8_t overflow_mode, uint8_t alignment) {
+  return text_hash ^ ((uint32_t)width << 16) ^ (font_key << 8) ^ (overflow_mode << 4) ^ alignment;
+}
+
+//! Measures text in a frame `width` wide, remembering recent results
+static GSize prv_measure_text(SimplyStage *self, const char *text, uint8_t font_key,
+                              uint16_t width, uint8_t overflow_mode, uint8_t alignment) {
+  TextSizeCache *cache = self->text_sizes;
+  if (!cache && (cache = self->text_sizes = malloc(sizeof(*cache)))) {
+    lru_init(&cache->table, cache->buckets, TEXT_SIZE_CACHE_BUCKETS);
+    cache->num_entries = 0;
+  }
+
+  const uint32_t text_hash = strhash(text);
+  const uint32_t key = prv_text_size_key(text_hash, font_key, width, overflow_mode, alignment);
+  TextSizeEntry *entry = cache ? (TextSizeEntry *)lru_find(&cache->table, key) : NULL;
+  if (entry && entry->text_hash == text_hash && entry->font_key == font_key &&
+      entry->width == width && entry->overflow_mode == overflow_mode &&
+      entry->alignment == alignment) {
+    lru_touch(&cache->table, &entry->node);
+    return entry->size;
+  }
+
+  // A very large frame height ensures we get the true content size
+  GSize size = graphics_text_layout_get_content_size(
+      text, prv_get_text_size_font(font_key), GRect(0, 0, width, 10000), overflow_mode,
+      alignment);
   // Add a small buffer to ensure text isn't cut off
-  text_size.h += 5; // Add 5px padding
+  size.h += 5;
 
-  // Send the size (width and height) back to JavaScript
-  CalculateTextSizeResponsePacket packet_response = {
-    .packet = {
-      .type = CommandCalculateTextSizeResponse,
-      .length = sizeof(CalculateTextSizeResponsePacket),
-    },
-    .width = text_size.w,
-    .height = text_size.h,
+  if (!cache) {
+    return size;
+  }
+  if (entry) {
+    // A different measurement with the same key, replace it
+    lru_remove(&cache->table, &entry->node);
+  } else if (cache->num_entries < TEXT_SIZE_CACHE_SIZE) {
+    entry = &cache->entries[cache->num_entries++];
+  } else {
+    entry = (TextSizeEntry *)lru_remove(&cache->table, lru_last(&cache->table));
+  }
+  *entry = (TextSizeEntry) {
+    .text_hash = text_hash,
+    .width = width,
+    .font_key = font_key,
+    .overflow_mode = overflow_mode,
+    .alignment = alignment,
+    .size = size,
   };
+  lru_insert(&cache->table, &entry->node, key);
+  return size;
+}
+
+static void handle_calculate_text_sizes_packet(Simply *simply, Packet *data) {
+  CalculateTextSizesPacket *packet = (CalculateTextSizesPacket*) data;
+  uint8_t buffer[sizeof(CalculateTextSizesResponsePacket) +
+                 TEXT_SIZE_BATCH_MAX * sizeof(TextSizeResult)];
+  CalculateTextSizesResponsePacket *response = (CalculateTextSizesResponsePacket *)buffer;
+
+  // Every request that can be read is answered, a malformed one with a zero size. Requests are
+  // variable length, so the ids after one that overruns the packet are lost and the phone
+  // answers them itself when the response arrives.
+  uint8_t num_results = 0;
+  if (data->length >= sizeof(*packet)) {
+    const uint8_t num_requests = MIN(packet->num_requests, TEXT_SIZE_BATCH_MAX);
+    const uint8_t *cursor = packet->requests;
+    const uint8_t *end = (uint8_t *)data + data->length;
+    while (num_results < num_requests && cursor + sizeof(TextSizeRequest) <= end) {
+      const TextSizeRequest *request = (TextSizeRequest *)cursor;
+      cursor += sizeof(TextSizeRequest) + request->text_length;
+      GSize size = GSizeZero;
+      if (request->text_length && cursor <= end && !request->text[request->text_length - 1]) {
+        size = prv_measure_text(simply->stage, request->text, request->font_key, request->width,
+                                request->overflow_mode, request->alignment);
+      }
+      response->results[num_results++] = (TextSizeResult) {
+        .request_id = request->request_id,
+        .width = size.w,
+        .height = size.h,
+      };
+    }
+  }
 
-  simply_msg_send_packet((Packet*) &packet_response);
+  response->packet = (Packet) {
+    .type = CommandCalculateTextSizesResponse,
+    .length = sizeof(*response) + num_results * sizeof(TextSizeResult),
+  };
+  response->num_results = num_results;
+  simply_msg_send_packet(&response->packet);
 }
 
 bool simply_stage_handle_packet(Simply *simply, Packet *packet) {
@@ -832,8 +935,8 @@ bool simply_stage_handle_packet(Simply *simply, Packet *packet) {
     case CommandElementAnimate:
       handle_element_animate_packet(simply, packet);
       return true;
-    case CommandCalculateTextSize:
-      handle_calculate_text_size_packet(simply, packet);
+    case CommandCalculateTextSizes:
+      handle_calculate_text_sizes_packet(simply, packet);
       return true;
   }
   return false;
@@ -864,5 +967,6 @@ void simply_stage_destroy(SimplyStage *self) {
 
   simply_window_deinit(&self->window);
 
+  free(self->text_sizes);
   free(self);
 }
@@ -9,9 +9,16 @@
 #include "util/inverter_layer.h"
 #include "util/list1.h"
 #include "util/color.h"
+#include "util/platform.h"
 
 #include <pebble.h>
 
+//! Text measurements remembered by the stage
+#define TEXT_SIZE_CACHE_SIZE IF_APLITE_ELSE(16, 64)
+
+//! Most text size requests in one CalculateTextSizesPacket, the phone batches at most this many
+#define TEXT_SIZE_BATCH_MAX 32
+
 #define simply_stage_get_element(self, id) simply_stage_auto_element(self, id, SimplyElementTypeNone)
 
 typedef struct SimplyStageLayer SimplyStageLayer;
@@ -20,6 +27,8 @@ typedef struct SimplyStage SimplyStage;
 
 typedef struct SimplyStageItem SimplyStageItem;
 
+typedef struct TextSizeCache TextSizeCache;
+
 typedef enum SimplyElementType SimplyElementType;
 
 enum SimplyElementType {
@@ -42,6 +51,8 @@ struct SimplyStageLayer {
 struct SimplyStage {
   SimplyWindow window;
   SimplyStageLayer stage_layer;
+  //! Allocated with the first measurement request
+  TextSizeCache *text_sizes;
 };
 
 typedef struct SimplyElementCommon SimplyElementCommon;
@@ -81,6 +92,8 @@ struct SimplyElementText {
   SimplyElementRect rect;
   char *text;
   GFont font;
+  //! Resource id of a custom font this element holds a reference to
+  uint32_t custom_font;
   TimeUnits time_units:8;
   GColor8 text_color;
   GTextOverflowMode overflow_mode:2;
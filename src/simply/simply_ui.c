@@ -134,16 +134,26 @@ void simply_ui_clear(SimplyUi *self, uint32_t clear_mask) {
   }
 }
 
-void simply_ui_set_style(SimplyUi *self, int style_index) {
+//! Drops the reference to the custom body font of the current style
+static void release_style_font(SimplyUi *self) {
   if (self->ui_layer.custom_body_font) {
-    fonts_unload_custom_font(self->ui_layer.custom_body_font);
+    simply_res_release_font(self->window.simply->res, self->ui_layer.style->custom_body_font_id);
     self->ui_layer.custom_body_font = NULL;
   }
-  self->ui_layer.style = &STYLES[style_index];
-  if (self->ui_layer.style->custom_body_font_id) {
-    self->ui_layer.custom_body_font = fonts_load_custom_font(
-        resource_get_handle(self->ui_layer.style->custom_body_font_id));
+}
+
+static void retain_style_font(SimplyUi *self) {
+  const SimplyStyle *style = self->ui_layer.style;
+  if (!self->ui_layer.custom_body_font && style && style->custom_body_font_id) {
+    self->ui_layer.custom_body_font =
+        simply_res_retain_font(self->window.simply->res, style->custom_body_font_id);
   }
+}
+
+void simply_ui_set_style(SimplyUi *self, int style_index) {
+  release_style_font(self);
+  self->ui_layer.style = &STYLES[style_index];
+  retain_style_font(self);
   mark_dirty(self);
 }
 
@@ -217,12 +227,15 @@ static void layer_update_callback(Layer *layer, GContext *ctx) {
   GPoint title_pos, subtitle_pos, image_pos = GPointZero;
   GRect body_rect;
 
-  SimplyImage *title_icon = simply_res_get_image(
-      self->window.simply->res, self->ui_layer.imagefields[UiTitleIcon]);
-  SimplyImage *subtitle_icon = simply_res_get_image(
-      self->window.simply->res, self->ui_layer.imagefields[UiSubtitleIcon]);
-  SimplyImage *body_image = simply_res_get_image(
-      self->window.simply->res, self->ui_layer.imagefields[UiBodyImage]);
+  // Loading one image may evict another, keep each pinned until the card is drawn
+  SimplyRes *res = self->window.simply->res;
+  SimplyImage *title_icon = simply_res_get_image(res, self->ui_layer.imagefields[UiTitleIcon]);
+  simply_res_pin_image(res, title_icon);
+  SimplyImage *subtitle_icon =
+      simply_res_get_image(res, self->ui_layer.imagefields[UiSubtitleIcon]);
+  simply_res_pin_image(res, subtitle_icon);
+  SimplyImage *body_image = simply_res_get_image(res, self->ui_layer.imagefields[UiBodyImage]);
+  simply_res_pin_image(res, body_image);
 
   GRect title_icon_bounds =
       title_icon ? gbitmap_get_bounds(title_icon->bitmap) : GRectZero;
@@ -364,6 +377,10 @@ static void layer_update_callback(Layer *layer, GContext *ctx) {
                        GTextOverflowModeTrailingEllipsis, text_align, body_attributes);
   }
 
+  simply_res_unpin_image(res, title_icon ? title_icon->id : 0);
+  simply_res_unpin_image(res, subtitle_icon ? subtitle_icon->id : 0);
+  simply_res_unpin_image(res, body_image ? body_image->id : 0);
+
   graphics_text_attributes_destroy(title_attributes);
   graphics_text_attributes_destroy(subtitle_attributes);
   graphics_text_attributes_destroy(body_attributes);
@@ -398,12 +415,13 @@ static void window_load(Window *window) {
 static void window_appear(Window *window) {
   SimplyUi *self = window_get_user_data(window);
   simply_window_appear(&self->window);
+  retain_style_font(self);
 }
 
 static void window_disappear(Window *window) {
   SimplyUi *self = window_get_user_data(window);
   if (simply_window_disappear(&self->window)) {
-    simply_res_clear(self->window.simply->res);
+    release_style_font(self);
   }
 }
 
@@ -492,9 +510,7 @@ void simply_ui_destroy(SimplyUi *self) {
   }
 
   simply_ui_clear(self, ~0);
-
-  fonts_unload_custom_font(self->ui_layer.custom_body_font);
-  self->ui_layer.custom_body_font = NULL;
+  release_style_font(self);
 
   simply_window_deinit(&self->window);
 
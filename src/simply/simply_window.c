@@ -211,13 +211,19 @@ void simply_window_set_action_bar(SimplyWindow *self, bool use_action_bar) {
 void simply_window_set_action_bar_icon(SimplyWindow *self, ButtonId button, uint32_t id) {
   if (!self->action_bar_layer) { return; }
 
-  SimplyImage *icon = simply_res_auto_image(self->simply->res, id, true);
+  SimplyRes *res = self->simply->res;
+  SimplyImage *icon = simply_res_auto_image(res, id, true);
+
+  simply_res_unpin_image(res, self->action_bar_icons[button]);
+  self->action_bar_icons[button] = icon ? id : 0;
 
   if (!icon) {
     action_bar_layer_clear_icon(self->action_bar_layer, button);
     return;
   }
 
+  simply_res_pin_image(res, icon);
+
   if (icon->is_palette_black_and_white) {
     gbitmap_set_palette(icon->bitmap, s_button_palette, false);
   }
@@ -242,6 +248,8 @@ void simply_window_action_bar_clear(SimplyWindow *self) {
 
   for (ButtonId button = BUTTON_ID_UP; button <= BUTTON_ID_DOWN; ++button) {
     action_bar_layer_clear_icon(self->action_bar_layer, button);
+    simply_res_unpin_image(self->simply->res, self->action_bar_icons[button]);
+    self->action_bar_icons[button] = 0;
   }
 }
 
@@ -365,6 +373,10 @@ void simply_window_unload(SimplyWindow *self) {
   scroll_layer_destroy(self->scroll_layer);
   self->scroll_layer = NULL;
 
+  for (ButtonId button = BUTTON_ID_UP; button <= BUTTON_ID_DOWN; ++button) {
+    simply_res_unpin_image(self->simply->res, self->action_bar_icons[button]);
+    self->action_bar_icons[button] = 0;
+  }
   action_bar_layer_destroy(self->action_bar_layer);
   self->action_bar_layer = NULL;
 
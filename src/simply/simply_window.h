@@ -19,6 +19,8 @@ struct SimplyWindow {
   ScrollLayer *scroll_layer;
   Layer *layer;
   ActionBarLayer *action_bar_layer;
+  //! Image ids pinned by the action bar per button, the layer holds their bitmaps
+  uint32_t action_bar_icons[NUM_BUTTONS];
   const WindowHandlers *window_handlers;
   uint32_t id;
   ButtonId button_mask:4;
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Intrusive hashed LRU table.
+ * Nodes are indexed by a 32-bit key in a caller provided bucket array and kept in a doubly linked
+ * recency list, so lookup, touch, insert and evicting the least recently used node are all O(1).
+ */
+
+typedef struct LruNode LruNode;
+
+struct LruNode {
+  LruNode *prev;
+  LruNode *next;
+  LruNode *bucket_next;
+  uint32_t key;
+};
+
+typedef struct LruTable LruTable;
+
+struct LruTable {
+  LruNode **buckets;
+  LruNode *head;
+  LruNode *tail;
+  uint16_t bucket_mask;
+  uint16_t size;
+};
+
+//! Initializes a table over `num_buckets` buckets. `num_buckets` must be a power of two.
+static inline void lru_init(LruTable *table, LruNode **buckets, uint16_t num_buckets) {
+  for (uint16_t i = 0; i < num_buckets; ++i) {
+    buckets[i] = NULL;
+  }
+  *table = (LruTable) {
+    .buckets = buckets,
+    .bucket_mask = num_buckets - 1,
+  };
+}
+
+static inline LruNode **lru_bucket(LruTable *table, uint32_t key) {
+  return &table->buckets[(key ^ (key >> 16)) & table->bucket_mask];
+}
+
+static inline LruNode *lru_find(LruTable *table, uint32_t key) {
+  for (LruNode *node = *lru_bucket(table, key); node; node = node->bucket_next) {
+    if (node->key == key) {
+      return node;
+    }
+  }
+  return NULL;
+}
+
+static inline void lru_unlink(LruTable *table, LruNode *node) {
+  if (node->prev) {
+    node->prev->next = node->next;
+  } else {
+    table->head = node->next;
+  }
+  if (node->next) {
+    node->next->prev = node->prev;
+  } else {
+    table->tail = node->prev;
+  }
+  node->prev = node->next = NULL;
+}
+
+static inline void lru_link_head(LruTable *table, LruNode *node) {
+  node->prev = NULL;
+  node->next = table->head;
+  if (table->head) {
+    table->head->prev = node;
+  } else {
+    table->tail = node;
+  }
+  table->head = node;
+}
+
+//! Marks a node as the most recently used.
+static inline void lru_touch(LruTable *table, LruNode *node) {
+  if (table->head == node) {
+    return;
+  }
+  lru_unlink(table, node);
+  lru_link_head(table, node);
+}
+
+//! Inserts a node as the most recently used. The key must not already be present.
+static inline LruNode *lru_insert(LruTable *table, LruNode *node, uint32_t key) {
+  LruNode **bucket = lru_bucket(table, key);
+  node->key = key;
+  node->bucket_next = *bucket;
+  *bucket = node;
+  lru_link_head(table, node);
+  table->size++;
+  return node;
+}
+
+static inline LruNode *lru_remove(LruTable *table, LruNode *node) {
+  if (!node) { return NULL; }
+  for (LruNode **ref = lru_bucket(table, node->key); *ref; ref = &(*ref)->bucket_next) {
+    if (*ref == node) {
+      *ref = node->bucket_next;
+      break;
+    }
+  }
+  node->bucket_next = NULL;
+  lru_unlink(table, node);
+  table->size--;
+  return node;
+}
+
+//! Returns the least recently used node.
+static inline LruNode *lru_last(LruTable *table) {
+  return table->tail;
+}
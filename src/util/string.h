@@ -2,6 +2,7 @@
 
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 
 static inline bool is_string(const char *str) {
@@ -46,6 +47,15 @@ static inline bool strset(char **str_field, const char *str) {
   return strnset(str_field, str, strlen2(str));
 }
 
+//! 32-bit FNV-1a hash of a string
+static inline uint32_t strhash(const char *str) {
+  uint32_t hash = 0x811c9dc5;
+  for (; str && *str; str++) {
+    hash = (hash ^ (uint8_t) *str) * 0x01000193;
+  }
+  return hash;
+}
+
 static inline void strset_truncated(char **str_field, const char *str) {
   size_t n = strlen2(str);
   for (; !strnset(str_field, str, n) && n > 1; n /= 2) {}
@@ -0,0 +1,205 @@
+import json
+import os
+import struct
+import zlib
+
+from waflib import Logs
+from waflib.Configure import conf
+
+ICON_PREFIX = 'IMAGE_ICON_'
+ATLAS_WIDTH = 128
+ATLAS_FILE = 'icon_atlas/icon_atlas.png'
+ATLAS_INDEX_FILE = 'icon_atlas/icon_atlas_index.bin'
+
+PNG_SIGNATURE = b'\x89PNG\r\n\x1a\n'
+CHANNELS = {0: 1, 2: 3, 3: 1, 4: 2, 6: 4}
+
+
+def read_png(path):
+    """Decodes an 8-bit non-interlaced PNG into (width, height, rows of RGBA tuples)."""
+    with open(path, 'rb') as f:
+        data = f.read()
+    if data[:8] != PNG_SIGNATURE:
+        raise ValueError('{} is not a PNG'.format(path))
+
+    offset = 8
+    idat = b''
+    palette = []
+    alphas = b''
+    while offset < len(data):
+        length, kind = struct.unpack('>I4s', data[offset:offset + 8])
+        body = data[offset + 8:offset + 8 + length]
+        offset += 12 + length
+        if kind == b'IHDR':
+            width, height, depth, color_type, _, _, interlace = struct.unpack('>IIBBBBB', body)
+            if depth != 8 or interlace or color_type not in CHANNELS:
+                raise ValueError('{} must be an 8-bit non-interlaced PNG'.format(path))
+        elif kind == b'PLTE':
+            palette = [tuple(bytearray(body[i:i + 3])) for i in range(0, len(body), 3)]
+        elif kind == b'tRNS':
+            alphas = bytearray(body)
+        elif kind == b'IDAT':
+            idat += body
+        elif kind == b'IEND':
+            break
+
+    channels = CHANNELS[color_type]
+    stride = width * channels
+    raw = bytearray(zlib.decompress(idat))
+    rows = []
+    prev = bytearray(stride)
+    for y in range(height):
+        start = y * (stride + 1)
+        kind = raw[start]
+        line = raw[start + 1:start + 1 + stride]
+        for i in range(stride):
+            a = line[i - channels] if i >= channels else 0
+            b = prev[i]
+            c = prev[i - channels] if i >= channels else 0
+            if kind == 1:
+                line[i] = (line[i] + a) & 0xff
+            elif kind == 2:
+                line[i] = (line[i] + b) & 0xff
+            elif kind == 3:
+                line[i] = (line[i] + ((a + b) >> 1)) & 0xff
+            elif kind == 4:
+                p = a + b - c
+                pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+                pred = a if pa <= pb and pa <= pc else (b if pb <= pc else c)
+                line[i] = (line[i] + pred) & 0xff
+        prev = line
+
+        pixels = []
+        for x in range(width):
+            px = line[x * channels:(x + 1) * channels]
+            if color_type == 0:
+                pixels.append((px[0], px[0], px[0], 255))
+            elif color_type == 2:
+                pixels.append((px[0], px[1], px[2], 255))
+            elif color_type == 3:
+                alpha = alphas[px[0]] if px[0] < len(alphas) else 255
+                pixels.append(palette[px[0]] + (alpha,))
+            elif color_type == 4:
+                pixels.append((px[0], px[0], px[0], px[1]))
+            else:
+                pixels.append(tuple(px))
+        rows.append(pixels)
+    return width, height, rows
+
+
+def quantize(pixel):
+    """Rounds an RGBA pixel to the 64 colours and 4 alpha levels of a Pebble GColor8."""
+    r, g, b, a = [(channel + 42) // 85 * 85 for channel in pixel]
+    return (r, g, b, a) if a else (0, 0, 0, 0)
+
+
+def palette_depth(num_colors):
+    """Smallest palettized bit depth holding `num_colors`."""
+    for depth in (1, 2, 4, 8):
+        if num_colors <= 1 << depth:
+            return depth
+    raise ValueError('{} colours do not fit a Pebble palette'.format(num_colors))
+
+
+def bitmap_size(width, height, num_colors):
+    """Heap bytes of the palettized GBitmap the SDK converts such an image to."""
+    depth = palette_depth(num_colors)
+    return (width * depth + 7) // 8 * height + (1 << depth)
+
+
+def write_png(path, width, height, rows):
+    """Encodes rows of quantized RGBA tuples as a palettized PNG of the smallest bit depth."""
+    def chunk(kind, body):
+        return (struct.pack('>I', len(body)) + kind + body +
+                struct.pack('>I', zlib.crc32(kind + body) & 0xffffffff))
+
+    palette = sorted(set(pixel for row in rows for pixel in row))
+    indexes = dict((pixel, index) for index, pixel in enumerate(palette))
+    depth = palette_depth(len(palette))
+    per_byte = 8 // depth
+
+    raw = bytearray()
+    for row in rows:
+        raw.append(0)
+        line = bytearray((width + per_byte - 1) // per_byte)
+        for x, pixel in enumerate(row):
+            shift = 8 - depth * (x % per_byte + 1)
+            line[x // per_byte] |= indexes[pixel] << shift
+        raw.extend(line)
+    with open(path, 'wb') as f:
+        f.write(PNG_SIGNATURE)
+        f.write(chunk(b'IHDR', struct.pack('>IIBBBBB', width, height, depth, 3, 0, 0, 0)))
+        f.write(chunk(b'PLTE', bytes(bytearray(c for pixel in palette for c in pixel[:3]))))
+        f.write(chunk(b'tRNS', bytes(bytearray(pixel[3] for pixel in palette))))
+        f.write(chunk(b'IDAT', zlib.compress(bytes(raw), 9)))
+        f.write(chunk(b'IEND', b''))
+
+
+def pack_shelves(icons, atlas_width):
+    """Places icons on shelves, tallest first. Returns the atlas height."""
+    x = y = shelf_height = 0
+    for icon in sorted(icons, key=lambda icon: (-icon['height'], icon['id'])):
+        if x + icon['width'] > atlas_width:
+            x = 0
+            y += shelf_height
+            shelf_height = 0
+        icon['x'] = x
+        icon['y'] = y
+        x += icon['width']
+        shelf_height = max(shelf_height, icon['height'])
+    return y + shelf_height
+
+
+@conf
+def generate_icon_atlas(ctx):
+    """
+    Packs every IMAGE_ICON_* bitmap of appinfo.json into the ICON_ATLAS bitmap resource.
+
+    The atlas is quantized to the Pebble palette and written palettized, so it loads at the
+    smallest bit depth its colours allow. An atlas that would take more heap than all its icons
+    loaded one by one is left empty and the icons are served from their own resources.
+
+    ICON_ATLAS_INDEX is a raw resource describing the atlas: a little endian uint16 entry count,
+    then per icon its uint16 resource id and uint8 x, y, width and height within the atlas.
+    The individual icon resources stay declared so resource ids do not change. Both files are
+    generated into the build directory, appinfo.json refers to them there.
+    """
+    with open('appinfo.json', 'r') as appinfo_file:
+        media = json.load(appinfo_file)['resources']['media']
+
+    icons = []
+    icons_size = 0
+    for index, resource in enumerate(media):
+        if not resource['name'].startswith(ICON_PREFIX) or resource['type'] != 'bitmap':
+            continue
+        path = os.path.join('resources', resource['file'])
+        width, height, rows = read_png(path)
+        rows = [[quantize(pixel) for pixel in row] for row in rows]
+        num_colors = len(set(pixel for row in rows for pixel in row))
+        icons_size += bitmap_size(width, height, num_colors)
+        icons.append({'id': index + 1, 'width': width, 'height': height, 'rows': rows})
+
+    atlas_height = pack_shelves(icons, ATLAS_WIDTH)
+    atlas = [[(0, 0, 0, 0)] * ATLAS_WIDTH for _ in range(atlas_height)]
+    for icon in icons:
+        for dy, row in enumerate(icon['rows']):
+            atlas[icon['y'] + dy][icon['x']:icon['x'] + icon['width']] = row
+
+    num_colors = len(set(pixel for row in atlas for pixel in row))
+    atlas_size = bitmap_size(ATLAS_WIDTH, atlas_height, num_colors)
+    if atlas_size > icons_size:
+        Logs.pprint('YELLOW', 'Icon atlas of {} bytes exceeds its {} icons of {} bytes, '
+                    'leaving it empty'.format(atlas_size, len(icons), icons_size))
+        icons = []
+        atlas = [[(0, 0, 0, 0)]]
+
+    atlas_node = ctx.path.get_bld().make_node(ATLAS_FILE)
+    index_node = ctx.path.get_bld().make_node(ATLAS_INDEX_FILE)
+    atlas_node.parent.mkdir()
+
+    write_png(atlas_node.abspath(), len(atlas[0]), len(atlas), atlas)
+    with open(index_node.abspath(), 'wb') as f:
+        f.write(struct.pack('<H', len(icons)))
+        for icon in sorted(icons, key=lambda icon: icon['id']):
+            f.write(struct.pack('<HBBBB', icon['id'], icon['x'], icon['y'],
+                                icon['width'], icon['height']))